@@ -0,0 +1,128 @@
+/**
+ * This example demonstrates the PT_LOCALS() facility. It is the
+ * producer/consumer example of 10-pt-sem-buffer, but with two
+ * producer instances running the very same protothread function.
+ *
+ * In 10-pt-sem-buffer the producer keeps its loop counter in a
+ * static variable. Running two producers from that function would
+ * make them share (and corrupt) that counter. Here the counter lives
+ * in a locals frame attached to each struct pt instead. The frames
+ * are taken from a fixed-block pool when an instance starts and are
+ * given back when the instance reaches PT_FINALIZED, so the pool can
+ * be sized for the number of live instances.
+ *
+ * Build with PT_CONF_LOCALS set to 1 (e.g. -DPT_CONF_LOCALS=1 in the
+ * build flags), since it changes struct pt for every translation unit.
+ */
+
+#include <protoduino.h>
+#include <sys/pt/sem.h>
+#include <sys/pt/locals.h>
+#include <dbg/print.h>
+
+#define NUM_ITEMS 8
+#define BUFSIZE 4
+#define NUM_FRAMES 3
+
+static uint8_t buffer[BUFSIZE];
+static uint8_t bufhead, buftail;
+
+static struct pt_sem full, empty;
+
+/* The locals frame of the producer and consumer protothreads. */
+PT_LOCALS(producer) {
+  uint8_t produced;
+};
+
+PT_LOCALS(consumer) {
+  uint8_t consumed;
+};
+
+/* One pool serves the frames of both protothread functions, so its
+ * blocks must fit the largest frame. */
+#define FRAME_SIZE (sizeof(void*) > sizeof(PT_LOCALS(producer)) \
+  ? sizeof(void*) : sizeof(PT_LOCALS(producer)))
+
+static uint8_t frames_buffer[FRAME_SIZE * NUM_FRAMES];
+static struct ipc_pool frames;
+PT_LOCALS_CHECK(producer, FRAME_SIZE);
+PT_LOCALS_CHECK(consumer, FRAME_SIZE);
+
+static PT_THREAD(producer(struct pt *pt, uint8_t base))
+{
+  PT_BEGIN_LOCALS(pt, producer, &frames);
+
+  for(PT_FRAME(pt, producer)->produced = 0;
+      PT_FRAME(pt, producer)->produced < NUM_ITEMS;
+      ++PT_FRAME(pt, producer)->produced) {
+
+    PT_SEM_WAIT(pt, &full);
+
+    buffer[bufhead] = base + PT_FRAME(pt, producer)->produced;
+    bufhead = (bufhead + 1) % BUFSIZE;
+
+    PT_SEM_SIGNAL(pt, &empty);
+  }
+
+  PT_END_LOCALS(pt, &frames);
+}
+
+static PT_THREAD(consumer(struct pt *pt))
+{
+  PT_BEGIN_LOCALS(pt, consumer, &frames);
+
+  for(PT_FRAME(pt, consumer)->consumed = 0;
+      PT_FRAME(pt, consumer)->consumed < NUM_ITEMS * 2;
+      ++PT_FRAME(pt, consumer)->consumed) {
+
+    PT_SEM_WAIT(pt, &empty);
+
+    print_line_val_P(PSTR("Item consumed:"), buffer[buftail]);
+    buftail = (buftail + 1) % BUFSIZE;
+
+    PT_SEM_SIGNAL(pt, &full);
+  }
+
+  PT_END_LOCALS(pt, &frames);
+}
+
+static PT_THREAD(driver_thread(struct pt *pt))
+{
+  static struct pt pt_producer1, pt_producer2, pt_consumer;
+
+  PT_BEGIN(pt);
+
+  PT_SEM_INIT(&empty, 0);
+  PT_SEM_INIT(&full, BUFSIZE);
+  bufhead = buftail = 0;
+
+  PT_INIT_LOCALS(&pt_producer1);
+  PT_INIT_LOCALS(&pt_producer2);
+  PT_INIT(&pt_consumer);
+
+  PT_WAIT_THREAD(pt, producer(&pt_producer1, 0) &
+         producer(&pt_producer2, 100) &
+         consumer(&pt_consumer));
+
+  print_line_val_P(PSTR("Free frames:"), ipc_pool_count_free(&frames));
+
+  PT_END(pt);
+}
+
+static struct pt driver_pt;
+
+void setup()
+{
+  print_setup();
+  ipc_pool_init(&frames, frames_buffer, FRAME_SIZE, NUM_FRAMES);
+}
+
+void loop()
+{
+  PT_INIT(&driver_pt);
+
+  while(PT_ISRUNNING(driver_thread(&driver_pt)))
+    ;
+
+  delay(2000);
+}
@@ -0,0 +1,83 @@
+/**
+ * This example demonstrates the PT_JOIN_ANY() and PT_JOIN_ALL()
+ * macros. A "reader" protothread waits for a random value above a
+ * threshold, which stands in for data arriving on a pipe. It races
+ * against a "timeout" protothread. Whichever child completes first
+ * wins; the other child is cancelled and driven through its finally
+ * block, so it can release whatever it holds.
+ *
+ * Afterwards both children are run with PT_JOIN_ALL(), which waits
+ * until both have completed.
+ */
+
+#include <protoduino.h>
+#include <sys/pt/join.h>
+#include <sys/pt/timer.h>
+#include <dbg/print.h>
+
+static ptstate_t reader(struct pt *self, void *arg)
+{
+  PT_BEGIN(self);
+
+  PT_WAIT_UNTIL(self, random(0, 255) > (uint8_t)(uintptr_t)arg);
+  print_line_P(PSTR("reader: data arrived"));
+
+  PT_FINALLY(self)
+
+  print_line_P(PSTR("reader: finally"));
+
+  PT_END(self);
+}
+
+static ptstate_t timeout(struct pt *self, void *arg)
+{
+  static struct timer t;
+
+  PT_BEGIN(self);
+
+  timer_set(&t, clock_from_millis((uint16_t)(uintptr_t)arg));
+  PT_WAIT_UNTIL(self, timer_expired(&t));
+  print_line_P(PSTR("timeout: expired"));
+
+  PT_FINALLY(self)
+
+  print_line_P(PSTR("timeout: finally"));
+
+  PT_END(self);
+}
+
+static struct pt_child race[] = {
+  PT_CHILD(reader, 250),
+  PT_CHILD(timeout, 10),
+};
+
+static ptstate_t main_driver(struct pt *self)
+{
+  PT_BEGIN(self);
+
+  PT_JOIN_ANY(self, race, CC_NELEM(race));
+  print_line_val_P(PSTR("PT_JOIN_ANY winner:"), pt_join_winner(race, CC_NELEM(race)));
+
+  PT_JOIN_ALL(self, race, CC_NELEM(race));
+  print_line_P(PSTR("PT_JOIN_ALL done"));
+
+  PT_END(self);
+}
+
+static struct pt pt1;
+
+void setup()
+{
+  print_setup();
+}
+
+void loop()
+{
+  PT_INIT(&pt1);
+
+  while(PT_ISRUNNING(main_driver(&pt1)))
+    ;
+
+  print_count++;
+  delay(2000);
+}
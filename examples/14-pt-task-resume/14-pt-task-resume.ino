@@ -0,0 +1,87 @@
+/**
+ * This example measures the cost of resuming a pd::task coroutine
+ * against the cost of scheduling a classic protothread. Both simply
+ * wait one cycle in an endless loop, so the measurement is the bare
+ * resume/suspend overhead of each implementation.
+ *
+ * pd::task needs a C++20 compiler with coroutine support. AVR gcc
+ * does not provide that, so this example only builds on larger
+ * targets (compile with -std=gnu++20).
+ */
+
+#include <protoduino.h>
+#include <sys/pt/task.hpp>
+#include <dbg/print.h>
+
+#define NUM_RESUMES 10000
+
+/* The frame of coroutine() is larger than 64 bytes with g++ on x86-64.
+ * Frames must also be aligned like memory from ::operator new.
+ */
+alignas(std::max_align_t) static uint8_t frames_buffer[2][128];
+static struct ipc_pool frames;
+
+static pd::task<void> coroutine(void)
+{
+  for (;;)
+    co_await pd::wait_one();
+}
+
+static CC_NO_INLINE ptstate_t protothread(struct pt *self)
+{
+  PT_BEGIN(self);
+
+  for (;;)
+    PT_WAIT_ONE(self);
+
+  PT_END(self);
+}
+
+static CC_NO_INLINE ptstate_t resume_task(pd::task<void> *t)
+{
+  return t->resume();
+}
+
+void setup()
+{
+  print_setup();
+  ipc_pool_init(&frames, frames_buffer, sizeof(frames_buffer[0]), 2);
+  pd::set_frame_pool(&frames);
+}
+
+void loop()
+{
+  static struct pt pt1;
+  static pd::task<void> task1;
+  uint32_t start, pt_us, task_us;
+
+  PT_INIT(&pt1);
+  start = micros();
+  for (uint16_t i = 0; i < NUM_RESUMES; i++)
+    protothread(&pt1);
+  pt_us = micros() - start;
+
+  task1 = coroutine();
+  if (!task1.valid())
+  {
+    /* the frame does not fit a block of frames_buffer */
+    print_error_P(PSTR("pd::task frame allocation failed"), ERR_HEAP_OOM);
+    delay(2000);
+    return;
+  }
+  start = micros();
+  for (uint16_t i = 0; i < NUM_RESUMES; i++)
+    resume_task(&task1);
+  task_us = micros() - start;
+  task1.finalize();
+
+  print_P(PSTR("protothread us/10000: "));
+  print(String(pt_us).c_str());
+  println();
+  print_P(PSTR("pd::task    us/10000: "));
+  print(String(task_us).c_str());
+  println();
+
+  print_count++;
+  delay(2000);
+}
@@ -0,0 +1,133 @@
+/**
+ * This example chains three generators into a pipeline: a byte
+ * source, a UTF-8 decoder and a VT100 key parser. Each key travels
+ * through the stages without any buffer in between.
+ *
+ * The byte source replays a fixed text instead of reading the serial
+ * port, so the example can measure the time per key of the pipeline
+ * against a hand written loop that does the same decoding inline.
+ * Replace text_read8 with serial0_read8 to parse real keyboard input.
+ */
+
+#include <protoduino.h>
+#include <sys/pt/gen.h>
+#include <lib/utf/utf8-gen.h>
+#include <dbg/print.h>
+
+#define NUM_KEYS 2000
+
+// 'é', '€', cursor up and delete
+static const char text[] = "protoduino \xc3\xa9\xe2\x82\xac \x1b[A\x1b[3~";
+static uint8_t text_pos;
+static volatile rune16_t sink;
+
+static int_fast16_t text_read8(void)
+{
+  uint8_t c = text[text_pos++];
+  if (text_pos == sizeof(text) - 1)
+    text_pos = 0;
+  return c;
+}
+
+static struct pt_gen_read8 bytes;
+static struct utf8_gen_decode runes;
+static struct vt_gen_keys keys;
+
+static ptstate_t pipeline(struct pt *self)
+{
+  static uint16_t count;
+
+  PT_BEGIN(self);
+
+  count = 0;
+  PT_FOREACH(self, &keys.gen, PT_GEN_NEXT(&keys.gen))
+  {
+    sink = keys.value;
+    if (++count == NUM_KEYS)
+      break; // finalizes all stages
+  }
+  PT_ENDEACH(self);
+
+  PT_END(self);
+}
+
+static CC_NO_INLINE void hand_loop(void)
+{
+  uint16_t count = 0;
+  uint8_t need = 0;
+  bool escaping = false;
+  uint8_t idx = 0;
+  char buf[VT_ESCAPE_BUFLEN];
+  rune16_t r = 0;
+
+  while (count < NUM_KEYS)
+  {
+    uint8_t b = text_read8();
+    if (need == 0)
+    {
+      if (b < 0x80) r = b;
+      else if ((b & 0xE0) == 0xC0) { r = b & 0x1F; need = 1; continue; }
+      else if ((b & 0xF0) == 0xE0) { r = b & 0x0F; need = 2; continue; }
+      else r = UTF8_DECODE_ERROR;
+    }
+    else
+    {
+      r = (r << 6) | (b & 0x3F);
+      if (--need > 0)
+        continue;
+    }
+
+    if (!escaping)
+    {
+      if (r == KEY_ESCAPE) { escaping = true; idx = 0; continue; }
+    }
+    else
+    {
+      int8_t ret = vt_escape_add(buf, &idx, r);
+      if (ret > 0)
+        continue;
+      escaping = false;
+      r = (ret == 0) ? vt_escape_match(buf, idx) : UTF8_DECODE_ERROR;
+    }
+
+    sink = r;
+    count++;
+  }
+}
+
+void setup()
+{
+  print_setup();
+}
+
+void loop()
+{
+  static struct pt pt1;
+  uint32_t start, hand_us, gen_us;
+
+  text_pos = 0;
+  start = micros();
+  hand_loop();
+  hand_us = micros() - start;
+
+  text_pos = 0;
+  pt_gen_read8_init(&bytes, text_read8);
+  utf8_gen_decode_init(&runes, &bytes.gen);
+  vt_gen_keys_init(&keys, &runes.gen);
+
+  PT_INIT(&pt1);
+  start = micros();
+  while (PT_ISRUNNING(pipeline(&pt1)))
+    ;
+  gen_us = micros() - start;
+
+  print_P(PSTR("hand loop us/2000 keys: "));
+  print(String(hand_us).c_str());
+  println();
+  print_P(PSTR("pipeline  us/2000 keys: "));
+  print(String(gen_us).c_str());
+  println();
+
+  print_count++;
+  delay(2000);
+}
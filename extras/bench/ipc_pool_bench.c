@@ -0,0 +1,92 @@
+/**
+ * Host benchmark for the IPC block pool (docs/ipc.md, section 1.8).
+ *
+ * 1, 2, 4 and 8 threads allocate bursts of 1-8 blocks from one pool, fill
+ * them, check them and free them again. Prints ns per alloc or free and
+ * checks that every block comes back to the pool.
+ *
+ * Lock-free backend:
+ *   gcc -O2 -pthread -DIPC_CONF_POOL_LOCKFREE=1 -Dfloat32_t=float \
+ *       -Isrc -Isrc/sys extras/bench/ipc_pool_bench.c -o bench_lockfree
+ * Locked backend, with CC_ATOMIC_RESTORE() mapped to a mutex:
+ *   gcc -O2 -pthread -Dfloat32_t=float \
+ *       -Isrc -Isrc/sys extras/bench/ipc_pool_bench.c -o bench_locked
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "cc.h"
+
+#if !IPC_CONF_POOL_LOCKFREE
+static pthread_mutex_t bench_lock = PTHREAD_MUTEX_INITIALIZER;
+#undef CC_ATOMIC_RESTORE
+#define CC_ATOMIC_RESTORE() \
+    for (int _l = (pthread_mutex_lock(&bench_lock), 1); _l; _l = (pthread_mutex_unlock(&bench_lock), 0))
+#endif
+
+#include "sys/ipc.c"
+
+#define BENCH_BLOCKS  256
+#define BENCH_ITER    2000000L
+#define BENCH_THREADS 8
+
+static struct ipc_pool pool;
+static uint64_t pool_buf[BENCH_BLOCKS * 4];
+static volatile int bad;
+
+static void *worker(void *arg)
+{
+    uint8_t id = (uint8_t)(uintptr_t)arg;
+    void *held[8];
+    for (long i = 0; i < BENCH_ITER; ++i) {
+        int k = (int)(i % 8) + 1;
+        int n = 0;
+        for (int j = 0; j < k; ++j) {
+            void *b = ipc_pool_alloc(&pool);
+            if (b) {
+                memset(b, id, 32);
+                held[n++] = b;
+            }
+        }
+        for (int j = 0; j < n; ++j) {
+            uint8_t *b = held[j];
+            for (int q = 0; q < 32; ++q) {
+                if (b[q] != id) bad = 1;
+            }
+            ipc_pool_free(&pool, b);
+        }
+    }
+#if IPC_CONF_POOL_LOCKFREE
+    ipc_pool_thread_flush();
+#endif
+    return NULL;
+}
+
+int main(void)
+{
+    printf("%s pool, %d blocks of 32 bytes\n",
+           IPC_CONF_POOL_LOCKFREE ? "lock-free" : "locked", BENCH_BLOCKS);
+    for (int t = 1; t <= BENCH_THREADS; t *= 2) {
+        pthread_t th[BENCH_THREADS];
+        struct timespec s, e;
+        ipc_pool_init(&pool, pool_buf, 32, BENCH_BLOCKS);
+        clock_gettime(CLOCK_MONOTONIC, &s);
+        for (int i = 0; i < t; ++i) pthread_create(&th[i], NULL, worker, (void *)(uintptr_t)(i + 1));
+        for (int i = 0; i < t; ++i) pthread_join(th[i], NULL);
+        clock_gettime(CLOCK_MONOTONIC, &e);
+
+        double ns = (e.tv_sec - s.tv_sec) * 1e9 + (e.tv_nsec - s.tv_nsec);
+        double ops = (double)t * BENCH_ITER * 4.5 * 2;  /* 4.5 blocks per burst, alloc + free */
+        uint16_t counted = ipc_pool_count_free(&pool);
+        int taken = 0;
+        while (ipc_pool_alloc(&pool)) taken++;
+        printf("threads %d: %5.1f ns/op, free %u, recovered %d/%d%s\n",
+               t, ns / ops, (unsigned)counted, taken, BENCH_BLOCKS, bad ? ", CORRUPT" : "");
+#if IPC_CONF_POOL_LOCKFREE
+        ipc_pool_thread_flush();
+#endif
+    }
+    return 0;
+}
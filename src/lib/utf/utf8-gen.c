@@ -0,0 +1,130 @@
+#include "utf8-gen.h"
+
+static ptstate_t decode_next(struct pt_gen *self)
+{
+  struct utf8_gen_decode *g = (struct utf8_gen_decode *)self;
+  uint8_t b;
+
+  PT_BEGIN(self);
+
+  g->need = 0;
+  PT_GEN_FOREACH(self)
+  {
+    b = PT_GEN_VALUE(self->src, uint8_t);
+    if (g->need != 0 && (b & 0b11000000) != 0b10000000)
+    {
+      // the sequence is broken off: report it, then b starts a new one
+      g->need = 0;
+      g->value = UTF8_DECODE_ERROR;
+      PT_YIELD(self);
+      b = PT_GEN_VALUE(self->src, uint8_t);
+    }
+
+    if (g->need == 0)
+    {
+      if (b < 0b10000000)
+      {
+        g->value = b;
+        PT_YIELD(self);
+      }
+      else if ((b & 0b11100000) == 0b11000000)
+      {
+        g->value = b & 0b00011111;
+        g->need = 1;
+        g->corrupt = false;
+      }
+      else if ((b & 0b11110000) == 0b11100000)
+      {
+        g->value = b & 0b00001111;
+        g->need = 2;
+        g->corrupt = false;
+      }
+      else if ((b & 0b11111000) == 0b11110000)
+      {
+        // does not fit in a rune16_t
+        g->need = 3;
+        g->corrupt = true;
+      }
+      else
+      {
+        g->value = UTF8_DECODE_ERROR;
+        PT_YIELD(self);
+      }
+    }
+    else
+    {
+      g->value = (rune16_t)((g->value << 6) | (b & 0b00111111));
+      if (--g->need == 0)
+      {
+        if (g->corrupt)
+          g->value = UTF8_DECODE_ERROR;
+        PT_YIELD(self);
+      }
+    }
+  }
+  PT_ENDEACH(self);
+
+  PT_FINALLY(self)
+
+  pt_gen_close(self->src);
+
+  PT_END(self);
+}
+
+void utf8_gen_decode_init(struct utf8_gen_decode *g, struct pt_gen *src)
+{
+  pt_gen_init(&g->gen, decode_next, src, &g->value, sizeof(g->value));
+  g->need = 0;
+  g->corrupt = false;
+}
+
+static ptstate_t keys_next(struct pt_gen *self)
+{
+  struct vt_gen_keys *g = (struct vt_gen_keys *)self;
+  rune16_t r;
+  int8_t ret;
+
+  PT_BEGIN(self);
+
+  g->escaping = false;
+  PT_GEN_FOREACH(self)
+  {
+    r = PT_GEN_VALUE(self->src, rune16_t);
+    if (!g->escaping)
+    {
+      if (r == KEY_ESCAPE)
+      {
+        g->escaping = true;
+        g->idx = 0;
+      }
+      else
+      {
+        g->value = r;
+        PT_YIELD(self);
+      }
+    }
+    else if ((ret = vt_escape_add(g->buf, &g->idx, r)) <= 0)
+    {
+      // the escape sequence is complete or invalid
+      g->escaping = false;
+      g->value = (ret == 0)
+        ? vt_escape_match(g->buf, g->idx)
+        : UTF8_DECODE_ERROR;
+      PT_YIELD(self);
+    }
+  }
+  PT_ENDEACH(self);
+
+  PT_FINALLY(self)
+
+  pt_gen_close(self->src);
+
+  PT_END(self);
+}
+
+void vt_gen_keys_init(struct vt_gen_keys *g, struct pt_gen *src)
+{
+  pt_gen_init(&g->gen, keys_next, src, &g->value, sizeof(g->value));
+  g->escaping = false;
+  g->idx = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef __UTF8_GEN_H__
+#define __UTF8_GEN_H__
+
+#include <cc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <sys/pt/gen.h>
+#include "utf8.h"
+#include "vt100.h"
+
+/**
+ * @brief Generator that decodes a byte generator into runes.
+ *
+ * The source must yield uint8_t values, for example a pt_gen_read8
+ * source. Each complete UTF-8 sequence is yielded as one rune16_t.
+ * Sequences that are corrupt, or that encode a code point above
+ * U+FFFF, are yielded as UTF8_DECODE_ERROR. A byte that breaks off a
+ * sequence ends it with UTF8_DECODE_ERROR and is then decoded as the
+ * start of the next one.
+ */
+struct utf8_gen_decode {
+  struct pt_gen gen;
+  rune16_t value;       // yielded rune
+  uint8_t need;         // continuation bytes still expected
+  bool corrupt;         // current sequence can not be represented
+};
+
+/**
+ * @brief Initializes a UTF-8 decoder stage.
+ *
+ * @param g   Pointer to the decoder stage.
+ * @param src Pointer to a generator that yields uint8_t values.
+ */
+CC_EXTERN void utf8_gen_decode_init(struct utf8_gen_decode *g, struct pt_gen *src);
+
+/**
+ * @brief Generator that turns VT100 escape sequences into key codes.
+ *
+ * The source must yield rune16_t values, for example a
+ * utf8_gen_decode stage. Runes that are not part of an escape sequence
+ * are passed on as is. An escape sequence is collected until its
+ * terminator and yielded as one KEY_* code, or as UTF8_DECODE_ERROR
+ * when it is unknown or does not fit in VT_ESCAPE_BUFLEN.
+ */
+struct vt_gen_keys {
+  struct pt_gen gen;
+  rune16_t value;               // yielded key or rune
+  bool escaping;                // inside an escape sequence
+  uint8_t idx;                  // current index of buffer
+  char buf[VT_ESCAPE_BUFLEN];   // current escape buffer
+};
+
+/**
+ * @brief Initializes a VT100 key parser stage.
+ *
+ * @param g   Pointer to the key parser stage.
+ * @param src Pointer to a generator that yields rune16_t values.
+ */
+CC_EXTERN void vt_gen_keys_init(struct vt_gen_keys *g, struct pt_gen *src);
+
+#endif
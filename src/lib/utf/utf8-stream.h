@@ -117,4 +117,160 @@ int utf8_puts_P(Stream *st, const rune16_t * rune);
  */
 int utf8_puti(Stream *st, uint8_t value);
 
+/**
+ * @brief Generic versions of utf8_getr() and utf8_putr() for a concrete stream class.
+ *
+ * The Stream* functions above call available(), peek(), read(), availableForWrite() and write() through the
+ * vtable, once per byte. These templates take a pointer to the concrete class instead. When that class is
+ * final (like PipeStream), the calls are direct and can be inlined. Overload resolution picks them for any
+ * pointer other than a Stream*, e.g. utf8_getr(&pipe_stream, &rune); the Stream* functions are the
+ * instances of the same code for S = Stream.
+ *
+ * utf8_putr() encodes the rune first and hands all of its bytes to one write(buffer, size) call.
+ *
+ * Return values are those of the Stream* functions.
+ *
+ * @see utf8_getr
+ * @see utf8_putr
+ */
+template <class S>
+int8_t utf8_getr(S *st, rune16_t *rune)
+{
+  uint8_t s0, s1, s2, s3;
+  int size;
+
+  *rune = UTF8_DECODE_ERROR;
+
+  size = st->available();
+  if (size == 0)
+    return 0;
+
+  /*
+   * one character sequence
+   *  00000-0007F => T1
+   *  0b0xxxxxxx
+   */
+  s0 = (uint8_t)st->peek();
+  if (s0 < 0b10000000)
+  {
+    st->read();
+    *rune = s0;
+    return 1;
+  }
+
+  /*
+   * two character sequence
+   *  0080-07FF => T2 Tx
+   *  0b110xxxxx  0b10xxxxxx
+   */
+  if ((s0 & 0b11100000) == 0b11000000)
+  {
+    if (size < 2)
+      return 0;
+
+    s0 = (uint8_t)st->read();
+    s1 = (uint8_t)st->read();
+    if ((s1 & 0b11000000) != 0b10000000)
+      return UTF8_RET_CORRUPT;
+
+    *rune = (((s0 & 0b00011111) << 6) | (s1 & 0b00111111));
+    return 2;
+  }
+
+  /*
+   * three character sequence
+   *  0800-FFFF => T3 Tx Tx
+   *  0b1110xxxx  0b10xxxxxx  0b10xxxxxx
+   */
+  if ((s0 & 0b11110000) == 0b11100000)
+  {
+    if (size < 3)
+      return 0;
+
+    s0 = (uint8_t)st->read();
+    s1 = (uint8_t)st->read();
+    if ((s1 & 0b11000000) != 0b10000000)
+      return UTF8_RET_CORRUPT;
+    s2 = (uint8_t)st->read();
+    if ((s2 & 0b11000000) != 0b10000000)
+      return UTF8_RET_CORRUPT;
+
+    *rune = (((((s0 & 0b00001111) << 6) | (s1 & 0b00111111)) << 6) | (s2 & 0b00111111));
+    return 3;
+  }
+
+  /*
+   * four character sequence
+   *  10000-10FFFF => T4 Tx Tx Tx
+   *  0b11110xxx  0b10xxxxxx  0b10xxxxxx  0b10xxxxxx
+   */
+  if ((s0 & 0b11111000) == 0b11110000)
+  {
+    // we cant implement this, because our rune is 16 bits wide.
+    // we take it from the stream anyways.
+
+    if (size < 4)
+      return 0;
+
+    s0 = (uint8_t)st->read();
+    s1 = (uint8_t)st->read();
+    if ((s1 & 0b11000000) != 0b10000000)
+      return UTF8_RET_CORRUPT;
+    s2 = (uint8_t)st->read();
+    if ((s2 & 0b11000000) != 0b10000000)
+      return UTF8_RET_CORRUPT;
+    s3 = (uint8_t)st->read();
+    if ((s3 & 0b11000000) != 0b10000000)
+      return UTF8_RET_CORRUPT;
+
+    return UTF8_RET_OVERFLOW;
+  }
+
+  return UTF8_RET_INCOMPLETE;
+}
+
+template <class S>
+int8_t utf8_putr(S *st, const rune16_t rune)
+{
+  uint8_t buf[3];
+  uint8_t n;
+
+  /*
+   * one character sequence
+   *  00000-0007F => 00-7F
+   */
+  if (rune < 0x80)
+  {
+    buf[0] = (uint8_t)rune;
+    n = 1;
+  }
+  /*
+   * two character sequence
+   *  00080-007FF => T2 Tx
+   */
+  else if (rune < 0x800)
+  {
+    buf[0] = 0b11000000 | (uint8_t)(rune >> 6);
+    buf[1] = 0b10000000 | (uint8_t)(rune & 0b00111111);
+    n = 2;
+  }
+  /*
+   * three character sequence
+   *  00800-0FFFF => T3 Tx Tx
+   */
+  else
+  {
+    buf[0] = 0b11100000 | (uint8_t)(rune >> 12);
+    buf[1] = 0b10000000 | (uint8_t)((rune >> 6) & 0b00111111);
+    buf[2] = 0b10000000 | (uint8_t)(rune & 0b00111111);
+    n = 3;
+  }
+
+  if (st->availableForWrite() < n)
+    return 0;
+
+  st->write(buf, n);
+  return n;
+}
+
 #endif
@@ -133,7 +133,7 @@ rune16_t vt_escape_match(const char * buffer, const uint8_t len)
     uint8_t size = (len < VT_ESCAPE_BUFLEN) ? len : VT_ESCAPE_BUFLEN;
     for(int idx = 0; idx < vt_key_mappings_size; ++idx)
     {
-        if (strncmp_P(buffer, vt_key_mappings[idx].vt_seq, size))
+        if (strncmp_P(buffer, vt_key_mappings[idx].vt_seq, size) == 0)
         {
             return vt_key_mappings[idx].key;
         }       
@@ -3,12 +3,16 @@
 #include "main.h"
 #include "sys/process.h"
 #include "sys/process/logger.h"
+#include "sys/ipc/slab.h"
 
 #if PROCESS_CONF_AUTO_IPC_POOL
 // Define the static buffer and the global pool structure instance.
 // The size is calculated at compile time based on IPC_CONF_MSG_BLOCK_COUNT.
 static uint8_t sys_pool_buffer[sizeof(ipc_msg_t) * IPC_CONF_MSG_BLOCK_COUNT];
 struct ipc_pool g_sys_msg_pool;
+#if IPC_CONF_POOL_OWNER
+static uint8_t sys_pool_owners[IPC_CONF_MSG_BLOCK_COUNT];
+#endif
 #endif
 
 struct process *system_log_process = NULL;
@@ -23,6 +27,15 @@ void protoduino_start() {
       sizeof(ipc_msg_t),
       IPC_CONF_MSG_BLOCK_COUNT
   );
+#if IPC_CONF_POOL_OWNER
+  // Track owners, so blocks left behind by exited processes are reclaimed.
+  ipc_pool_track(&g_sys_msg_pool, sys_pool_owners);
+#endif
+#endif
+
+#if IPC_CONF_SLAB
+  // Carve the slab arena into its size classes (ipc_alloc/ipc_free).
+  ipc_slab_init();
 #endif
 
   // 2. Initialize the scheduler and link the error logger.
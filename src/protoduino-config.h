@@ -4,6 +4,7 @@
 #define __PROTODUINO_CONFIG_H__
 
 #include "./sys/errors.conf.h"
+#include "./sys/pt.conf.h"
 #include "./sys/serial.conf.h"
 #include "./sys/process.conf.h"
 #include "./sys/ipc.conf.h"
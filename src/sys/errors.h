@@ -538,7 +538,7 @@ static CC_ALWAYS_INLINE uint8_t err_op_distance(uint8_t left, uint8_t right) {
     return err_op_one_count(left ^ right);
 }
 
-static CC_ALWAYS_INLINE very_fast_log2(float val) {
+static CC_ALWAYS_INLINE float very_fast_log2(float val) {
   union { float f; uint32_t i; } convert;
   convert.f = val;
   return (float)((convert.i >> 23) - 127);   // only integer part, error up to ~1
@@ -1,8 +1,22 @@
 // file: ./src/sys/ipc.c
 
 #include "ipc.h"
+#include "../lib/ringb8.h"
 #include <string.h>
 #include <stdio.h>   /* snprintf used only in debug helper */
+#if IPC_CONF_POOL_STATS || IPC_CONF_TIMESTAMP
+#include "clock.h"
+#endif
+#if IPC_CONF_POOL_STATS
+#include "serial.h"
+#endif
+
+#if IPC_CONF_SIGNAL
+/* Run the signal callback of a pool or pipe, outside the atomic block */
+#define IPC_SIGNAL(x) do { if ((x)->signal_cb) (x)->signal_cb((x)->signal_ctx); } while (0)
+#else
+#define IPC_SIGNAL(x) do { } while (0)
+#endif
 
 /* -------------------------------------------------------------------------
  * IPC pool implementation (fixed-block free-list). Deterministic & tiny.
@@ -11,6 +25,223 @@
  * CC_ATOMIC_RESTORE() macro that maps to ATOMIC_BLOCK(ATOMIC_RESTORESTATE).
  * ----------------------------------------------------------------------*/
 
+#if IPC_CONF_POOL_OWNER
+uint8_t ipc_owner_current = IPC_OWNER_NONE;
+
+/* Pools with an owner table, see ipc_pool_track() */
+static struct ipc_pool *tracked_pools = NULL;
+
+static void pool_untrack(struct ipc_pool *p)
+{
+    CC_ATOMIC_RESTORE() {
+        struct ipc_pool **q = &tracked_pools;
+        while (*q) {
+            if (*q == p) {
+                *q = p->next_tracked;
+                break;
+            }
+            q = &((*q)->next_tracked);
+        }
+    }
+}
+
+/* Tracked pool that contains blk, or NULL */
+static struct ipc_pool *tracked_pool_of(const void *blk)
+{
+    const uint8_t *b = (const uint8_t*)blk;
+    for (struct ipc_pool *q = tracked_pools; q != NULL; q = q->next_tracked) {
+        if (b >= q->buffer && b < q->buffer + q->block_size * q->n_blocks) return q;
+    }
+    return NULL;
+}
+#endif
+
+#if IPC_CONF_POOL_OWNER || IPC_CONF_POOL_STATS || IPC_CONF_POOL_LOCKFREE
+static uint16_t pool_index(const struct ipc_pool *p, const void *blk)
+{
+    return (uint16_t)(((const uint8_t*)blk - p->buffer) / p->block_size);
+}
+#endif
+
+#if IPC_CONF_POOL_LOCKFREE
+/* -------------------------------------------------------------------------
+ * Lock-free backend (host only). The free list is a Treiber stack of block
+ * numbers (index + 1, 0 ends the list) kept in the first 4 bytes of each
+ * free block. The head packs a tag next to the top block number; every
+ * successful push or pop increments the tag, so a pop that raced with a
+ * pop and push of the same top block (ABA) fails its compare-and-swap.
+ *
+ * The head also counts the blocks on the stack, so that count changes in
+ * the same compare-and-swap as the top.
+ *
+ * In front of the stack every thread keeps a magazine of blocks per pool.
+ * An empty magazine is refilled with half a magazine from the stack, a full
+ * one returns half to it, so a thread that allocates and frees in turn
+ * stays in its magazine. The magazines live in a table with one cache line
+ * aligned row per thread, claimed on first use, so ipc_pool_count_free()
+ * can add up the blocks they cache. Only the owning thread writes a row.
+ * ----------------------------------------------------------------------*/
+
+#define LF_TAG(h)                ((uint32_t)((h) >> 32))
+#define LF_COUNT(h)              ((uint16_t)((h) >> 16))
+#define LF_TOP(h)                ((uint16_t)(h))
+#define LF_HEAD(tag, count, top) (((uint64_t)(tag) << 32) | ((uint32_t)(count) << 16) | (top))
+
+struct lf_magazine {
+    struct ipc_pool *pool;    /* pool the cached blocks belong to, NULL = unused */
+    uint16_t count;           /* cached blocks */
+    void *blk[IPC_CONF_POOL_MAG_SIZE];
+};
+
+struct lf_thread {
+    struct lf_magazine mags[IPC_CONF_POOL_MAG_POOLS];
+    bool used;                /* row claimed by a thread */
+} __attribute__((aligned(64)));
+
+static struct lf_thread lf_threads[IPC_CONF_POOL_MAG_THREADS];
+static _Thread_local struct lf_thread *lf_self;
+static _Thread_local bool lf_no_row;  /* the table was full when this thread looked */
+
+static uint32_t *lf_block(struct ipc_pool *p, uint32_t num)
+{
+    return (uint32_t*)(p->buffer + (size_t)(num - 1) * p->block_size);
+}
+
+static void lf_push(struct ipc_pool *p, void *blk)
+{
+    uint32_t num = (uint32_t)pool_index(p, blk) + 1;
+    uint64_t old = __atomic_load_n(&p->lf_head, __ATOMIC_RELAXED);
+    uint64_t top;
+    do {
+        __atomic_store_n((uint32_t*)blk, LF_TOP(old), __ATOMIC_RELAXED);
+        top = LF_HEAD(LF_TAG(old) + 1, LF_COUNT(old) + 1, num);
+    } while (!__atomic_compare_exchange_n(&p->lf_head, &old, top, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static void *lf_pop(struct ipc_pool *p)
+{
+    uint64_t old = __atomic_load_n(&p->lf_head, __ATOMIC_ACQUIRE);
+    uint64_t next;
+    do {
+        if (LF_TOP(old) == 0) return NULL;
+        /* the link is stale when another thread took the block meanwhile,
+         * but then the tag has moved on and the exchange fails */
+        uint32_t link = __atomic_load_n(lf_block(p, LF_TOP(old)), __ATOMIC_RELAXED);
+        next = LF_HEAD(LF_TAG(old) + 1, LF_COUNT(old) - 1, link);
+    } while (!__atomic_compare_exchange_n(&p->lf_head, &old, next, true,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+    return lf_block(p, LF_TOP(old));
+}
+
+/* Row of the calling thread; claims a free one, NULL when the table is full */
+static struct lf_thread *lf_thread_row(void)
+{
+    if (lf_self || lf_no_row) return lf_self;
+    for (uint8_t i = 0; i < IPC_CONF_POOL_MAG_THREADS; ++i) {
+        bool expected = false;
+        if (__atomic_compare_exchange_n(&lf_threads[i].used, &expected, true, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            lf_self = &lf_threads[i];
+            return lf_self;
+        }
+    }
+    lf_no_row = true;
+    return NULL;
+}
+
+/* Magazine of the calling thread for p; claims a free slot, NULL when none is left */
+static struct lf_magazine *lf_magazine(struct ipc_pool *p)
+{
+    struct lf_thread *t = lf_thread_row();
+    if (!t) return NULL;
+    struct lf_magazine *spare = NULL;
+    for (uint8_t i = 0; i < IPC_CONF_POOL_MAG_POOLS; ++i) {
+        if (t->mags[i].pool == p) return &t->mags[i];
+        if (!t->mags[i].pool && !spare) spare = &t->mags[i];
+    }
+    if (spare) {
+        spare->count = 0;
+        __atomic_store_n(&spare->pool, p, __ATOMIC_RELAXED);
+    }
+    return spare;
+}
+
+static void *lf_alloc(struct ipc_pool *p)
+{
+    void *blk = NULL;
+    struct lf_magazine *m = lf_magazine(p);
+    if (m) {
+        uint16_t n = m->count;
+        while (n < IPC_CONF_POOL_MAG_SIZE / 2) {
+            void *b = lf_pop(p);
+            if (!b) break;
+            m->blk[n++] = b;
+        }
+        if (n > 0) blk = m->blk[--n];
+        __atomic_store_n(&m->count, n, __ATOMIC_RELAXED);
+    }
+    else {
+        blk = lf_pop(p);
+    }
+#if IPC_CONF_POOL_OWNER
+    if (blk && p->owners) p->owners[pool_index(p, blk)] = ipc_owner_current;
+#endif
+    return blk;
+}
+
+static void lf_free(struct ipc_pool *p, void *blk)
+{
+#if IPC_CONF_POOL_OWNER
+    if (p->owners) p->owners[pool_index(p, blk)] = IPC_OWNER_NONE;
+#endif
+    struct lf_magazine *m = lf_magazine(p);
+    if (m) {
+        uint16_t n = m->count;
+        if (n == IPC_CONF_POOL_MAG_SIZE) {
+            while (n > IPC_CONF_POOL_MAG_SIZE / 2) lf_push(p, m->blk[--n]);
+        }
+        m->blk[n++] = blk;
+        __atomic_store_n(&m->count, n, __ATOMIC_RELAXED);
+    }
+    else {
+        lf_push(p, blk);
+    }
+}
+
+/* Blocks on the stack plus the blocks cached in all magazines; a snapshot
+ * while other threads allocate and free */
+static uint16_t lf_count_free(struct ipc_pool *p)
+{
+    uint32_t n = LF_COUNT(__atomic_load_n(&p->lf_head, __ATOMIC_RELAXED));
+    for (uint8_t t = 0; t < IPC_CONF_POOL_MAG_THREADS; ++t) {
+        for (uint8_t i = 0; i < IPC_CONF_POOL_MAG_POOLS; ++i) {
+            struct lf_magazine *m = &lf_threads[t].mags[i];
+            if (__atomic_load_n(&m->pool, __ATOMIC_RELAXED) == p)
+                n += __atomic_load_n(&m->count, __ATOMIC_RELAXED);
+        }
+    }
+    return (uint16_t)(n < p->n_blocks ? n : p->n_blocks);
+}
+
+void ipc_pool_thread_flush(void)
+{
+    struct lf_thread *t = lf_self;
+    lf_no_row = false;
+    if (!t) return;
+    for (uint8_t i = 0; i < IPC_CONF_POOL_MAG_POOLS; ++i) {
+        struct lf_magazine *m = &t->mags[i];
+        while (m->count > 0) {
+            lf_push(m->pool, m->blk[m->count - 1]);
+            __atomic_store_n(&m->count, (uint16_t)(m->count - 1), __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&m->pool, NULL, __ATOMIC_RELAXED);
+    }
+    lf_self = NULL;
+    __atomic_store_n(&t->used, false, __ATOMIC_RELEASE);
+}
+#endif
+
 int ipc_pool_init(struct ipc_pool *p, void *buffer, size_t block_size, uint16_t n_blocks)
 {
     if (!p || !buffer || n_blocks == 0) return ERR_HANDLE_NULL;
@@ -20,6 +251,28 @@ int ipc_pool_init(struct ipc_pool *p, void *buffer, size_t block_size, uint16_t
     p->n_blocks = n_blocks;
     p->free_count = n_blocks;
     p->free_list = NULL;
+#if IPC_CONF_SIGNAL
+    p->signal_cb = NULL;
+    p->signal_ctx = NULL;
+#endif
+#if IPC_CONF_POOL_OWNER
+    /* re-initializing a tracked pool stops tracking; call ipc_pool_track() again */
+    pool_untrack(p);
+    p->owners = NULL;
+    p->next_tracked = NULL;
+#endif
+#if IPC_CONF_POOL_STATS
+    memset(&p->stats, 0, sizeof(p->stats));
+    p->stats.min_free = n_blocks;
+    p->stamps = NULL;
+#endif
+#if IPC_CONF_POOL_LOCKFREE
+    /* Build free stack: block i links to block number i + 2, the last ends it */
+    for (uint16_t i = 0; i < n_blocks; ++i) {
+        *((uint32_t*)(p->buffer + (size_t)i * block_size)) = (i + 1 < n_blocks) ? (uint32_t)i + 2 : 0;
+    }
+    __atomic_store_n(&p->lf_head, LF_HEAD(0, n_blocks, 1), __ATOMIC_RELEASE);
+#else
     /* Build free list: place pointer to next in first sizeof(void*) bytes of each block */
     for (int i = (int)n_blocks - 1; i >= 0; --i) {
         void *blk = p->buffer + (size_t)i * block_size;
@@ -27,37 +280,209 @@ int ipc_pool_init(struct ipc_pool *p, void *buffer, size_t block_size, uint16_t
         *((void**)blk) = p->free_list;
         p->free_list = blk;
     }
+#endif
     return ERR_SUCCESS;
 }
 
 void *ipc_pool_alloc(struct ipc_pool *p)
 {
     if (!p) return NULL;
+#if IPC_CONF_POOL_LOCKFREE
+    return lf_alloc(p);
+#else
     void *blk = NULL;
+#if IPC_CONF_POOL_STATS
+    uint32_t now = p->stamps ? clock_time() : 0;
+#endif
     CC_ATOMIC_RESTORE() {
         blk = p->free_list;
         if (blk) {
             p->free_list = *((void**)blk);
             p->free_count--;
+#if IPC_CONF_POOL_OWNER
+            if (p->owners) p->owners[pool_index(p, blk)] = ipc_owner_current;
+#endif
+        }
+#if IPC_CONF_POOL_STATS
+        if (blk) {
+            p->stats.allocs++;
+            if (p->free_count < p->stats.min_free) p->stats.min_free = p->free_count;
+            if (p->stamps) p->stamps[pool_index(p, blk)] = now;
+        }
+        else {
+            p->stats.fails++;
         }
+#endif
     }
     return blk;
+#endif
 }
 
 void ipc_pool_free(struct ipc_pool *p, void *blk)
 {
     if (!p || !blk) return;
+#if IPC_CONF_POOL_LOCKFREE
+    lf_free(p, blk);
+#else
+#if IPC_CONF_POOL_STATS
+    uint32_t now = p->stamps ? clock_time() : 0;
+#endif
     CC_ATOMIC_RESTORE() {
+#if IPC_CONF_POOL_STATS
+        p->stats.frees++;
+        if (p->stamps) {
+            uint32_t held = now - p->stamps[pool_index(p, blk)];
+            p->stats.timed++;
+            p->stats.held_total += held;
+            if (held > p->stats.held_max) p->stats.held_max = held;
+        }
+#endif
         *((void**)blk) = p->free_list;
         p->free_list = blk;
         p->free_count++;
+#if IPC_CONF_POOL_OWNER
+        if (p->owners) p->owners[pool_index(p, blk)] = IPC_OWNER_NONE;
+#endif
     }
+#endif
+    IPC_SIGNAL(p);
 }
 
 uint16_t ipc_pool_count_free(struct ipc_pool *p)
 {
+#if IPC_CONF_POOL_LOCKFREE
+    return (p ? lf_count_free(p) : 0);
+#else
     return (p ? p->free_count : 0);
+#endif
+}
+
+#if IPC_CONF_SIGNAL
+void ipc_pool_set_signal(struct ipc_pool *p, ipc_wake_cb_t cb, void *ctx)
+{
+    if (!p) return;
+    CC_ATOMIC_RESTORE() {
+        p->signal_cb = cb;
+        p->signal_ctx = ctx;
+    }
 }
+#endif
+
+#if IPC_CONF_POOL_STATS
+int ipc_pool_stats_time(struct ipc_pool *p, uint32_t *stamps)
+{
+    if (!p || !stamps) return ERR_HANDLE_NULL;
+    /* blocks that are out already get a stamp of now */
+    uint32_t now = clock_time();
+    for (uint16_t i = 0; i < p->n_blocks; ++i) stamps[i] = now;
+    CC_ATOMIC_RESTORE() {
+        p->stamps = stamps;
+    }
+    return ERR_SUCCESS;
+}
+
+int ipc_pool_get_stats(const struct ipc_pool *p, struct ipc_pool_stats *st)
+{
+    if (!p || !st) return ERR_HANDLE_NULL;
+    CC_ATOMIC_RESTORE() {
+        *st = p->stats;
+        st->n_blocks = p->n_blocks;
+        st->free_count = p->free_count;
+    }
+    return ERR_SUCCESS;
+}
+
+void ipc_pool_stats_reset(struct ipc_pool *p)
+{
+    if (!p) return;
+    CC_ATOMIC_RESTORE() {
+        memset(&p->stats, 0, sizeof(p->stats));
+        p->stats.min_free = p->free_count;
+    }
+}
+
+void ipc_pool_stats_dump(const struct ipc_pool *p, const char *name)
+{
+    struct ipc_pool_stats st;
+    if (ipc_pool_get_stats(p, &st) != ERR_SUCCESS) return;
+
+    /* the average never exceeds held_max, so it fits 32 bits */
+    uint32_t avg = st.timed ? (uint32_t)(st.held_total / st.timed) : 0;
+    print_P(PSTR("[POOL] "));
+    print(name ? name : "?");
+    print_P(PSTR(" free:"));
+    print_dec32(st.free_count);
+    printchar('/');
+    print_dec32(st.n_blocks);
+    print_P(PSTR(" min:"));
+    print_dec32(st.min_free);
+    print_P(PSTR(" alloc:"));
+    print_dec32(st.allocs);
+    print_P(PSTR(" free:"));
+    print_dec32(st.frees);
+    print_P(PSTR(" fail:"));
+    print_dec32(st.fails);
+    print_P(PSTR(" held avg:"));
+    print_dec32(avg);
+    print_P(PSTR(" max:"));
+    print_dec32(st.held_max);
+    print_P(PSTR("\r\n"));
+}
+#endif
+
+#if IPC_CONF_POOL_OWNER
+int ipc_pool_track(struct ipc_pool *p, uint8_t *owners)
+{
+    if (!p || !owners) return ERR_HANDLE_NULL;
+    memset(owners, IPC_OWNER_NONE, p->n_blocks);
+    pool_untrack(p);
+    CC_ATOMIC_RESTORE() {
+        p->owners = owners;
+        p->next_tracked = tracked_pools;
+        tracked_pools = p;
+    }
+    return ERR_SUCCESS;
+}
+
+int ipc_owner_set(const void *blk, uint8_t owner)
+{
+    if (!blk) return ERR_HANDLE_NULL;
+    struct ipc_pool *p = tracked_pool_of(blk);
+    if (!p) return ERR_MEM_BOUNDS;
+    CC_ATOMIC_RESTORE() {
+        p->owners[pool_index(p, blk)] = owner;
+    }
+    return ERR_SUCCESS;
+}
+
+uint8_t ipc_owner_get(const void *blk)
+{
+    struct ipc_pool *p = blk ? tracked_pool_of(blk) : NULL;
+    if (!p) return IPC_OWNER_UNTRACKED;
+    return p->owners[pool_index(p, blk)];
+}
+
+uint16_t ipc_owner_reclaim(uint8_t owner)
+{
+    uint16_t n = 0;
+    if (owner == IPC_OWNER_NONE || owner == IPC_OWNER_UNTRACKED) return 0;
+    for (struct ipc_pool *q = tracked_pools; q != NULL; q = q->next_tracked) {
+        for (uint16_t i = 0; i < q->n_blocks; ++i) {
+            bool mine;
+            /* claim the block first, so an ISR can not hand it on meanwhile */
+            CC_ATOMIC_RESTORE() {
+                mine = (q->owners[i] == owner);
+                if (mine) q->owners[i] = IPC_OWNER_NONE;
+            }
+            if (mine) {
+                ipc_pool_free(q, q->buffer + (size_t)i * q->block_size);
+                n++;
+            }
+        }
+    }
+    return n;
+}
+#endif
 
 /* -------------------------------------------------------------------------
  * Message helpers (msg struct uses argv pointers only - no deep-copy)
@@ -66,7 +491,20 @@ uint16_t ipc_pool_count_free(struct ipc_pool *p)
 ipc_msg_t *ipc_msg_alloc_from_pool(struct ipc_pool *pool)
 {
     if (!pool) return NULL;
-    return (ipc_msg_t*) ipc_pool_alloc(pool);
+    ipc_msg_t *m = (ipc_msg_t*) ipc_pool_alloc(pool);
+#if IPC_CONF_MSG_REFCOUNT
+    if (m) {
+        m->refs = 0;
+        m->pool = pool;
+    }
+#endif
+#if IPC_CONF_RPC
+    if (m) m->call_id = 0;
+#endif
+#if IPC_CONF_TIMESTAMP
+    if (m) m->stamp = clock_time();
+#endif
+    return m;
 }
 
 void ipc_msg_free_to_pool(struct ipc_pool *pool, ipc_msg_t *m)
@@ -75,6 +513,47 @@ void ipc_msg_free_to_pool(struct ipc_pool *pool, ipc_msg_t *m)
     ipc_pool_free(pool, (void*)m);
 }
 
+#if IPC_CONF_MSG_REFCOUNT
+ipc_msg_t *ipc_msg_alloc_shared(struct ipc_pool *pool)
+{
+    ipc_msg_t *m = ipc_msg_alloc_from_pool(pool);
+    if (m) {
+        m->refs = 1;
+#if IPC_CONF_POOL_OWNER
+        /* the reference count decides when it is freed, not its owner */
+        ipc_owner_set(m, IPC_OWNER_NONE);
+#endif
+    }
+    return m;
+}
+
+int ipc_msg_retain(ipc_msg_t *m)
+{
+    if (!m) return ERR_HANDLE_NULL;
+    int ret = ERR_SUCCESS;
+    CC_ATOMIC_RESTORE() {
+        if (m->refs == 0) ret = ERR_REF_ZERO;
+        else if (m->refs == UINT8_MAX) ret = ERR_REF_MAX;
+        else m->refs++;
+    }
+    return ret;
+}
+
+int ipc_msg_release(ipc_msg_t *m)
+{
+    if (!m) return ERR_HANDLE_NULL;
+    int ret = ERR_SUCCESS;
+    bool last = false;
+    CC_ATOMIC_RESTORE() {
+        if (m->refs == 0) ret = ERR_REF_ZERO;
+        else last = (--m->refs == 0);
+    }
+    /* outside the atomic block, so the pool's signal callback runs with interrupts on */
+    if (last) ipc_pool_free(m->pool, (void*)m);
+    return ret;
+}
+#endif
+
 int ipc_msg_init(ipc_msg_t *m, uint8_t type, uint8_t argc, void *argv[])
 {
     if (!m) return ERR_HANDLE_NULL;
@@ -85,6 +564,9 @@ int ipc_msg_init(ipc_msg_t *m, uint8_t type, uint8_t argc, void *argv[])
     for (uint8_t i = 0; i < IPC_MSG_MAX_ARGS; ++i) {
         m->argv[i] = (i < argc && argv) ? argv[i] : NULL;
     }
+#if IPC_CONF_RPC
+    m->call_id = 0;
+#endif
     return ERR_SUCCESS;
 }
 
@@ -105,8 +587,50 @@ int ipc_msg_set_arg(ipc_msg_t *m, uint8_t idx, void *arg)
  * pipe changed from empty->non-empty. The wake callback must be safe to call
  * from the context you're in (ISR or thread), or you must use your ISR
  * variant that posts to the scheduler.
+ *
+ * SPSC mode (ipc_pipe_init_spsc, IPC_CONF_PIPE_SPSC): mask != 0. The producer only stores head
+ * and the consumer only stores tail, so no atomic block is needed. Each side
+ * reads the other index with acquire and publishes its own with release
+ * semantics; the bytes are copied outside of any critical section.
  * ----------------------------------------------------------------------*/
 
+#if IPC_CONF_PIPE_SPSC
+#define PIPE_MASK(p) ((p)->mask)
+#else
+#define PIPE_MASK(p) ((void)(p), (size_t)0)  /* every pipe is locked */
+#endif
+
+#if defined(__AVR__)
+/* Single core and indices < 256, so a volatile access can not tear. The
+ * compiler barrier keeps buffer accesses on the right side of the update. */
+#define IPC_SPSC_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+static inline size_t spsc_load(const size_t *x)
+{
+    size_t v = *(const volatile size_t *)x;
+    IPC_SPSC_BARRIER();
+    return v;
+}
+
+static inline void spsc_store(size_t *x, size_t v)
+{
+    IPC_SPSC_BARRIER();
+    *(volatile size_t *)x = v;
+}
+#else
+#include <stdatomic.h>
+
+static inline size_t spsc_load(const size_t *x)
+{
+    return atomic_load_explicit((_Atomic size_t *)x, memory_order_acquire);
+}
+
+static inline void spsc_store(size_t *x, size_t v)
+{
+    atomic_store_explicit((_Atomic size_t *)x, v, memory_order_release);
+}
+#endif
+
 int ipc_pipe_init(ipc_pipe_t *p, void *buffer, size_t size, ipc_wake_cb_t wake_cb, void *wake_ctx)
 {
     if (!p || !buffer || size < 2) return ERR_PROC_INVAL;
@@ -116,13 +640,43 @@ int ipc_pipe_init(ipc_pipe_t *p, void *buffer, size_t size, ipc_wake_cb_t wake_c
     p->tail = 0;
     p->wake_cb = wake_cb;
     p->wake_ctx = wake_ctx;
+#if IPC_CONF_SIGNAL
+    p->signal_cb = NULL;
+    p->signal_ctx = NULL;
+#endif
+#if IPC_CONF_PIPE_SPACE
+    p->space_cb = NULL;
+    p->space_ctx = NULL;
+    p->space_low = 0;
+#endif
+#if IPC_CONF_PIPE_SPSC
+    p->mask = 0;
+#endif
+#if IPC_CONF_TIMESTAMP
+    p->stamp = 0;
+#endif
     /* zero buffer optional */
     return ERR_SUCCESS;
 }
 
+#if IPC_CONF_PIPE_SPSC
+int ipc_pipe_init_spsc(ipc_pipe_t *p, void *buffer, size_t size, ipc_wake_cb_t wake_cb, void *wake_ctx)
+{
+    if (size < 2 || (size & (size - 1)) != 0) return ERR_VAL_RANGE;
+#if defined(__AVR__)
+    if (size > 256) return ERR_VAL_RANGE;
+#endif
+    int ret = ipc_pipe_init(p, buffer, size, wake_cb, wake_ctx);
+    if (ret != ERR_SUCCESS) return ret;
+    p->mask = size - 1;
+    return ERR_SUCCESS;
+}
+#endif
+
 size_t ipc_pipe_available(const ipc_pipe_t *p)
 {
     if (!p) return 0;
+    if (PIPE_MASK(p)) return (spsc_load(&p->head) - spsc_load(&p->tail)) & PIPE_MASK(p);
     size_t h = p->head;
     size_t t = p->tail;
     return (h >= t) ? (h - t) : (p->size + h - t);
@@ -132,16 +686,66 @@ size_t ipc_pipe_space(const ipc_pipe_t *p)
 {
     if (!p) return 0;
     /* leave one slot empty to differentiate full vs empty */
+    if (PIPE_MASK(p)) return PIPE_MASK(p) - ipc_pipe_available(p);
     return p->size ? (p->size - ipc_pipe_available(p) - 1) : 0;
 }
 
+#if IPC_CONF_TIMESTAMP
+/* Record when a write makes the pipe non-empty, before the data is published */
+#define PIPE_STAMP(p, was_empty) do { if (was_empty) (p)->stamp = clock_time(); } while (0)
+#else
+#define PIPE_STAMP(p, was_empty) do { } while (0)
+#endif
+
+/* SPSC write: producer side only, no atomic block */
+static size_t spsc_write(ipc_pipe_t *p, const uint8_t *src, size_t len, bool *was_empty)
+{
+    size_t h = p->head;                 /* owned by the producer */
+    size_t t = spsc_load(&p->tail);
+    size_t space = (t - h - 1) & PIPE_MASK(p);
+    if (len > space) len = space;
+    if (len == 0) return 0;
+
+    size_t first = p->size - h;
+    if (first > len) first = len;
+    memcpy(&p->buf[h], src, first);
+    memcpy(&p->buf[0], src + first, len - first);
+
+    *was_empty = (h == t);
+    PIPE_STAMP(p, *was_empty);
+    spsc_store(&p->head, (h + len) & PIPE_MASK(p));
+    return len;
+}
+
+/* SPSC read: consumer side only, no atomic block */
+static size_t spsc_read(ipc_pipe_t *p, uint8_t *dst, size_t len, size_t *space)
+{
+    size_t t = p->tail;                 /* owned by the consumer */
+    size_t h = spsc_load(&p->head);
+    size_t avail = (h - t) & PIPE_MASK(p);
+    *space = PIPE_MASK(p) - avail;
+    if (len > avail) len = avail;
+    if (len == 0) return 0;
+
+    size_t first = p->size - t;
+    if (first > len) first = len;
+    memcpy(dst, &p->buf[t], first);
+    memcpy(dst + first, &p->buf[0], len - first);
+
+    spsc_store(&p->tail, (t + len) & PIPE_MASK(p));
+    return len;
+}
+
 size_t ipc_pipe_write(ipc_pipe_t *p, const uint8_t *src, size_t len)
 {
     if (!p || !src || len == 0) return 0;
     size_t written = 0;
     bool was_empty = false;
 
-    CC_ATOMIC_RESTORE() {
+    if (PIPE_MASK(p)) {
+        written = spsc_write(p, src, len, &was_empty);
+    }
+    else CC_ATOMIC_RESTORE() {
         size_t space = ipc_pipe_space(p);
         if (space == 0) { written = 0; }
         else {
@@ -160,6 +764,7 @@ size_t ipc_pipe_write(ipc_pipe_t *p, const uint8_t *src, size_t len)
             p->head = h;
             written = towrite;
             was_empty = (towrite > 0 && ipc_pipe_available(p) == towrite);
+            PIPE_STAMP(p, was_empty);
         }
     } /* atomic end */
 
@@ -169,16 +774,36 @@ size_t ipc_pipe_write(ipc_pipe_t *p, const uint8_t *src, size_t len)
     if (was_empty && p->wake_cb) {
         p->wake_cb(p->wake_ctx);
     }
+    if (written > 0) IPC_SIGNAL(p);
     return written;
 }
 
+/* Notify the writer when freeing `freed` bytes lifted the free space from
+ * below the low watermark to at or above it (edge triggered, like wake_cb).
+ */
+static void pipe_notify_space(ipc_pipe_t *p, size_t space, size_t freed)
+{
+#if IPC_CONF_PIPE_SPACE
+    if (p->space_cb && space < p->space_low && space + freed >= p->space_low) {
+        p->space_cb(p->space_ctx);
+    }
+#else
+    (void)p; (void)space; (void)freed;
+#endif
+}
+
 size_t ipc_pipe_read(ipc_pipe_t *p, uint8_t *dst, size_t len)
 {
     if (!p || !dst || len == 0) return 0;
     size_t read = 0;
+    size_t space = 0;
 
-    CC_ATOMIC_RESTORE() {
+    if (PIPE_MASK(p)) {
+        read = spsc_read(p, dst, len, &space);
+    }
+    else CC_ATOMIC_RESTORE() {
         size_t avail = ipc_pipe_available(p);
+        space = p->size - avail - 1;
         if (avail == 0) { read = 0; }
         else {
             size_t toread = (len <= avail) ? len : avail;
@@ -197,13 +822,424 @@ size_t ipc_pipe_read(ipc_pipe_t *p, uint8_t *dst, size_t len)
         }
     } /* atomic end */
 
+    if (read > 0) {
+        pipe_notify_space(p, space, read);
+    }
+    if (read > 0) IPC_SIGNAL(p);
+    return read;
+}
+
+/* Copy len bytes into the ring at head h (len fits); returns the new head */
+static size_t pipe_put(ipc_pipe_t *p, size_t h, const uint8_t *src, size_t len)
+{
+    size_t first = p->size - h;
+    if (first > len) first = len;
+    memcpy(&p->buf[h], src, first);
+    memcpy(&p->buf[0], src + first, len - first);
+    h += len;
+    return (h >= p->size) ? h - p->size : h;
+}
+
+/* Copy len bytes out of the ring at tail t (len available); returns the new tail */
+static size_t pipe_get(const ipc_pipe_t *p, size_t t, uint8_t *dst, size_t len)
+{
+    size_t first = p->size - t;
+    if (first > len) first = len;
+    memcpy(dst, &p->buf[t], first);
+    memcpy(dst + first, &p->buf[0], len - first);
+    t += len;
+    return (t >= p->size) ? t - p->size : t;
+}
+
+static size_t iov_total(const ipc_iovec_t *iov, uint8_t n)
+{
+    size_t total = 0;
+    for (uint8_t i = 0; i < n; ++i) total += iov[i].len;
+    return total;
+}
+
+size_t ipc_pipe_writev(ipc_pipe_t *p, const ipc_iovec_t *iov, uint8_t n)
+{
+    if (!p || !iov || n == 0) return 0;
+    size_t total = iov_total(iov, n);
+    size_t written = 0;
+    bool was_empty = false;
+    if (total == 0) return 0;
+
+    if (PIPE_MASK(p)) {
+        size_t h = p->head;
+        size_t t = spsc_load(&p->tail);
+        if (total <= ((t - h - 1) & PIPE_MASK(p))) {
+            for (uint8_t i = 0; i < n; ++i) h = pipe_put(p, h, (const uint8_t*)iov[i].base, iov[i].len);
+            was_empty = (p->head == t);
+            PIPE_STAMP(p, was_empty);
+            spsc_store(&p->head, h);
+            written = total;
+        }
+    }
+    else CC_ATOMIC_RESTORE() {
+        if (total <= ipc_pipe_space(p)) {
+            size_t h = p->head;
+            was_empty = (h == p->tail);
+            PIPE_STAMP(p, was_empty);
+            for (uint8_t i = 0; i < n; ++i) h = pipe_put(p, h, (const uint8_t*)iov[i].base, iov[i].len);
+            p->head = h;
+            written = total;
+        }
+    } /* atomic end */
+
+    if (was_empty && p->wake_cb) {
+        p->wake_cb(p->wake_ctx);
+    }
+    if (written > 0) IPC_SIGNAL(p);
+    return written;
+}
+
+size_t ipc_pipe_readv(ipc_pipe_t *p, const ipc_iovec_t *iov, uint8_t n)
+{
+    if (!p || !iov || n == 0) return 0;
+    size_t total = iov_total(iov, n);
+    size_t read = 0;
+    size_t space = 0;
+    if (total == 0) return 0;
+
+    if (PIPE_MASK(p)) {
+        size_t t = p->tail;
+        size_t avail = (spsc_load(&p->head) - t) & PIPE_MASK(p);
+        if (total <= avail) {
+            space = PIPE_MASK(p) - avail;
+            for (uint8_t i = 0; i < n; ++i) t = pipe_get(p, t, (uint8_t*)iov[i].base, iov[i].len);
+            spsc_store(&p->tail, t);
+            read = total;
+        }
+    }
+    else CC_ATOMIC_RESTORE() {
+        size_t avail = ipc_pipe_available(p);
+        if (total <= avail) {
+            size_t t = p->tail;
+            space = p->size - avail - 1;
+            for (uint8_t i = 0; i < n; ++i) t = pipe_get(p, t, (uint8_t*)iov[i].base, iov[i].len);
+            p->tail = t;
+            read = total;
+        }
+    } /* atomic end */
+
+    if (read > 0) {
+        pipe_notify_space(p, space, read);
+    }
+    if (read > 0) IPC_SIGNAL(p);
     return read;
 }
 
+/* Contiguous free bytes at head h with tail t; one slot stays empty */
+static size_t pipe_write_span(const ipc_pipe_t *p, size_t h, size_t t)
+{
+    if (t > h) return t - h - 1;
+    return p->size - h - (t == 0 ? 1 : 0);
+}
+
+/* Contiguous readable bytes at tail t with head h */
+static size_t pipe_read_span(const ipc_pipe_t *p, size_t h, size_t t)
+{
+    return (h >= t) ? (h - t) : (p->size - t);
+}
+
+/* Index owned by the other side of p: acquire load on SPSC pipes */
+static inline size_t pipe_load(const ipc_pipe_t *p, const size_t *x)
+{
+    return PIPE_MASK(p) ? spsc_load(x) : *x;
+}
+
+/* Publish an index owned by this side of p: release store on SPSC pipes */
+static inline void pipe_store(const ipc_pipe_t *p, size_t *x, size_t v)
+{
+    if (PIPE_MASK(p)) spsc_store(x, v);
+    else *x = v;
+}
+
+/* Copy up to max bytes from src to dst, one contiguous chunk (bounded by the
+ * end of either buffer) per atomic section. With consume the bytes leave src
+ * (splice), otherwise src is left alone (tee).
+ */
+static size_t pipe_move(ipc_pipe_t *dst, ipc_pipe_t *src, size_t max, bool consume)
+{
+    size_t done = 0;
+    size_t n;
+    size_t space = 0;           /* free space of src before the first chunk */
+    bool was_empty = false;     /* dst was empty before the first chunk */
+
+    do {
+        n = 0;
+        CC_ATOMIC_RESTORE() {
+            size_t off = consume ? 0 : done;
+            size_t sh = pipe_load(src, &src->head);
+            size_t avail = (sh + src->size - src->tail) % src->size;
+            size_t st = (src->tail + off) % src->size;
+            size_t dh = dst->head;
+            size_t dt = pipe_load(dst, &dst->tail);
+
+            n = max - done;
+            if (n > avail - off) n = avail - off;
+            if (n > src->size - st) n = src->size - st;
+            if (n > pipe_write_span(dst, dh, dt)) n = pipe_write_span(dst, dh, dt);
+            if (n > 0) {
+                memcpy(&dst->buf[dh], &src->buf[st], n);
+                if (done == 0) {
+                    was_empty = (dh == dt);
+                    space = src->size - 1 - avail;
+                    PIPE_STAMP(dst, was_empty);
+                }
+                pipe_store(dst, &dst->head, (dh + n) % dst->size);
+                if (consume) pipe_store(src, &src->tail, (st + n) % src->size);
+            }
+        } /* atomic end */
+        done += n;
+    } while (n > 0 && done < max);
+
+    if (done == 0) return 0;
+
+    if (was_empty && dst->wake_cb) {
+        dst->wake_cb(dst->wake_ctx);
+    }
+    IPC_SIGNAL(dst);
+    if (consume) {
+        pipe_notify_space(src, space, done);
+        IPC_SIGNAL(src);
+    }
+    return done;
+}
+
+size_t ipc_pipe_splice(ipc_pipe_t *dst, ipc_pipe_t *src, size_t max)
+{
+    if (!dst || !src || dst == src) return 0;
+    return pipe_move(dst, src, max, true);
+}
+
+size_t ipc_pipe_tee(ipc_pipe_t *dst, ipc_pipe_t *src, size_t max)
+{
+    if (!dst || !src || dst == src) return 0;
+    return pipe_move(dst, src, max, false);
+}
+
+size_t ipc_pipe_splice_ringb8(struct ringb8_t *dst, ipc_pipe_t *src, size_t max)
+{
+    if (!dst || !src) return 0;
+    size_t done = 0;
+    size_t n;
+    size_t space = 0;
+
+    do {
+        n = 0;
+        CC_ATOMIC_RESTORE() {
+            size_t sh = pipe_load(src, &src->head);
+            size_t avail = (sh + src->size - src->tail) % src->size;
+            size_t st = src->tail;
+            size_t size = (size_t)dst->mask + 1;
+            size_t dh = dst->head;
+            size_t dt = dst->tail;
+            /* contiguous free bytes of the ring, one slot stays empty */
+            size_t room = (dt > dh) ? (dt - dh - 1) : (size - dh - (dt == 0 ? 1 : 0));
+
+            n = max - done;
+            if (n > avail) n = avail;
+            if (n > src->size - st) n = src->size - st;
+            if (n > room) n = room;
+            if (n > 0) {
+                memcpy(&dst->data[dh], &src->buf[st], n);
+                if (done == 0) space = src->size - 1 - avail;
+                dst->head = (uint8_t)((dh + n) & dst->mask);
+                pipe_store(src, &src->tail, (st + n) % src->size);
+            }
+        } /* atomic end */
+        done += n;
+    } while (n > 0 && done < max);
+
+    if (done == 0) return 0;
+
+    pipe_notify_space(src, space, done);
+    IPC_SIGNAL(src);
+    return done;
+}
+
+int ipc_pipe_write_reserve(ipc_pipe_t *p, uint8_t **ptr, size_t *len)
+{
+    if (!p || !ptr || !len) return ERR_HANDLE_NULL;
+    if (PIPE_MASK(p)) {
+        *len = pipe_write_span(p, p->head, spsc_load(&p->tail));
+        *ptr = &p->buf[p->head];
+    }
+    else CC_ATOMIC_RESTORE() {
+        *len = pipe_write_span(p, p->head, p->tail);
+        *ptr = &p->buf[p->head];
+    }
+    return ERR_SUCCESS;
+}
+
+int ipc_pipe_write_commit(ipc_pipe_t *p, size_t n)
+{
+    if (!p) return ERR_HANDLE_NULL;
+    if (n == 0) return ERR_SUCCESS;
+    bool was_empty = false;
+    int ret = ERR_SUCCESS;
+
+    if (PIPE_MASK(p)) {
+        size_t h = p->head;
+        size_t t = spsc_load(&p->tail);
+        if (n > pipe_write_span(p, h, t)) {
+            ret = ERR_VAL_RANGE;
+        }
+        else {
+            was_empty = (h == t);
+            PIPE_STAMP(p, was_empty);
+            spsc_store(&p->head, (h + n) & PIPE_MASK(p));
+        }
+    }
+    else CC_ATOMIC_RESTORE() {
+        if (n > pipe_write_span(p, p->head, p->tail)) {
+            ret = ERR_VAL_RANGE;
+        }
+        else {
+            was_empty = (p->head == p->tail);
+            PIPE_STAMP(p, was_empty);
+            p->head = (p->head + n) % p->size;
+        }
+    }
+    if (ret != ERR_SUCCESS) return ret;
+
+    if (was_empty && p->wake_cb) {
+        p->wake_cb(p->wake_ctx);
+    }
+    IPC_SIGNAL(p);
+    return ERR_SUCCESS;
+}
+
+int ipc_pipe_read_peek(ipc_pipe_t *p, const uint8_t **ptr, size_t *len)
+{
+    if (!p || !ptr || !len) return ERR_HANDLE_NULL;
+    if (PIPE_MASK(p)) {
+        *len = pipe_read_span(p, spsc_load(&p->head), p->tail);
+        *ptr = &p->buf[p->tail];
+    }
+    else CC_ATOMIC_RESTORE() {
+        *len = pipe_read_span(p, p->head, p->tail);
+        *ptr = &p->buf[p->tail];
+    }
+    return ERR_SUCCESS;
+}
+
+int ipc_pipe_read_consume(ipc_pipe_t *p, size_t n)
+{
+    if (!p) return ERR_HANDLE_NULL;
+    if (n == 0) return ERR_SUCCESS;
+    int ret = ERR_SUCCESS;
+    size_t avail;
+
+    /* consuming more than the peeked span (but not more than available) skips bytes */
+    if (PIPE_MASK(p)) {
+        avail = ipc_pipe_available(p);
+        if (n > avail)
+            ret = ERR_VAL_RANGE;
+        else
+            spsc_store(&p->tail, (p->tail + n) & PIPE_MASK(p));
+    }
+    else CC_ATOMIC_RESTORE() {
+        avail = ipc_pipe_available(p);
+        if (n > avail) {
+            ret = ERR_VAL_RANGE;
+        }
+        else {
+            p->tail = (p->tail + n) % p->size;
+        }
+    }
+    if (ret != ERR_SUCCESS) return ret;
+
+    pipe_notify_space(p, p->size - 1 - avail, n);
+
+    IPC_SIGNAL(p);
+    return ERR_SUCCESS;
+}
+
 void ipc_pipe_clear(ipc_pipe_t *p)
 {
     if (!p) return;
-    CC_ATOMIC_RESTORE() {
+    size_t avail;
+    if (PIPE_MASK(p)) {
+        /* consumer side: drop everything the producer published so far */
+        size_t h = spsc_load(&p->head);
+        avail = (h - p->tail) & PIPE_MASK(p);
+        spsc_store(&p->tail, h);
+    }
+    else CC_ATOMIC_RESTORE() {
+        avail = ipc_pipe_available(p);
         p->head = p->tail = 0;
     }
+    if (avail > 0) {
+        pipe_notify_space(p, p->size - 1 - avail, avail);
+    }
+    IPC_SIGNAL(p);
+}
+
+#if IPC_CONF_SIGNAL
+void ipc_pipe_set_signal(ipc_pipe_t *p, ipc_wake_cb_t cb, void *ctx)
+{
+    if (!p) return;
+    CC_ATOMIC_RESTORE() {
+        p->signal_cb = cb;
+        p->signal_ctx = ctx;
+    }
+}
+#endif
+
+#if IPC_CONF_PIPE_SPACE
+void ipc_pipe_set_space(ipc_pipe_t *p, ipc_wake_cb_t cb, void *ctx, size_t low_watermark)
+{
+    if (!p) return;
+    /* the free space can never exceed size - 1 */
+    if (low_watermark == 0) low_watermark = 1;
+    if (low_watermark > p->size - 1) low_watermark = p->size - 1;
+    CC_ATOMIC_RESTORE() {
+        p->space_cb = cb;
+        p->space_ctx = ctx;
+        p->space_low = low_watermark;
+    }
+}
+#endif
+
+#if IPC_CONF_TIMESTAMP
+/* -------------------------------------------------------------------------
+ * Timestamps. Stamps are read in an atomic section, so a writer in an ISR
+ * can not tear the 32-bit value on AVR.
+ * ----------------------------------------------------------------------*/
+
+uint32_t ipc_msg_age(const ipc_msg_t *m)
+{
+    if (!m) return 0;
+    uint32_t stamp;
+    CC_ATOMIC_RESTORE() {
+        stamp = m->stamp;
+    }
+    return clock_time() - stamp;
+}
+
+void ipc_msg_stamp(ipc_msg_t *m)
+{
+    if (!m) return;
+    uint32_t now = clock_time();
+    CC_ATOMIC_RESTORE() {
+        m->stamp = now;
+    }
+}
+
+uint32_t ipc_pipe_age(const ipc_pipe_t *p)
+{
+    if (!p) return 0;
+    uint32_t stamp = 0;
+    bool empty;
+    CC_ATOMIC_RESTORE() {
+        /* head before stamp: on SPSC pipes the stamp is written before head */
+        empty = (ipc_pipe_available(p) == 0);
+        if (!empty) stamp = p->stamp;
+    }
+    return empty ? 0 : clock_time() - stamp;
 }
+#endif
@@ -8,4 +8,167 @@
 #define IPC_MSG_MAX_ARGS 4
 #endif
 
+/* Reference-counted messages (ipc_msg_alloc_shared/retain/release).
+ * Adds a count and a pool pointer to every ipc_msg_t. Needed by IPC_CONF_BUS.
+ */
+#ifndef IPC_CONF_MSG_REFCOUNT
+#define IPC_CONF_MSG_REFCOUNT 0
+#endif
+
+/* Owner tracking for pool blocks (ipc_pool_track, ipc_owner_reclaim).
+ * Tracked pools cost one byte per block; every process gets an owner id.
+ */
+#ifndef IPC_CONF_POOL_OWNER
+#define IPC_CONF_POOL_OWNER 0
+#endif
+
+/* Pool instrumentation (ipc_pool_get_stats, ipc_pool_stats_dump).
+ * Adds counters to every pool; timing costs 4 bytes per block when enabled
+ * with ipc_pool_stats_time().
+ */
+#ifndef IPC_CONF_POOL_STATS
+#define IPC_CONF_POOL_STATS 0
+#endif
+
+/* Lock-free pool backend for multi-threaded host builds (not AVR).
+ * The free list becomes a Treiber stack updated with compare-and-swap and
+ * every thread caches blocks in per-pool magazines, see docs/ipc.md.
+ * Cannot be combined with IPC_CONF_POOL_STATS.
+ */
+#ifndef IPC_CONF_POOL_LOCKFREE
+#define IPC_CONF_POOL_LOCKFREE 0
+#endif
+
+/* Blocks a thread caches per pool, and pools a thread caches blocks of */
+#ifndef IPC_CONF_POOL_MAG_SIZE
+#define IPC_CONF_POOL_MAG_SIZE 16
+#endif
+
+#ifndef IPC_CONF_POOL_MAG_POOLS
+#define IPC_CONF_POOL_MAG_POOLS 4
+#endif
+
+/* Threads that get magazines; any further thread uses the shared stack */
+#ifndef IPC_CONF_POOL_MAG_THREADS
+#define IPC_CONF_POOL_MAG_THREADS 8
+#endif
+
+/* Signal callbacks on pools and pipes (ipc_pool_set_signal, ipc_pipe_set_signal),
+ * e.g. for process_cond_signal(). Adds a callback and a context pointer to
+ * every pool and pipe; off by default, so existing pools and pipes keep
+ * their size.
+ */
+#ifndef IPC_CONF_SIGNAL
+#define IPC_CONF_SIGNAL 0
+#endif
+
+/* Writer-side space callbacks (ipc_pipe_set_space, ipc_mpipe_set_space).
+ * Adds a callback, a context pointer and a watermark to every pipe and
+ * multicast pipe; off by default. Needed by sys/ipc/graph.h.
+ */
+#ifndef IPC_CONF_PIPE_SPACE
+#define IPC_CONF_PIPE_SPACE 0
+#endif
+
+/* Lock-free single-producer/single-consumer pipes (ipc_pipe_init_spsc).
+ * Adds an index mask to every pipe; off by default.
+ */
+#ifndef IPC_CONF_PIPE_SPSC
+#define IPC_CONF_PIPE_SPSC 0
+#endif
+
+/* Size-class slab allocator (ipc_alloc/ipc_free, see sys/ipc/slab.h).
+ * Disabled by default; the arena costs the sum of size * count bytes of RAM.
+ */
+#ifndef IPC_CONF_SLAB
+#define IPC_CONF_SLAB 0
+#endif
+
+/* Number of blocks in each size class of the slab arena (0 disables a class) */
+#ifndef IPC_CONF_SLAB_8
+#define IPC_CONF_SLAB_8 8
+#endif
+
+#ifndef IPC_CONF_SLAB_16
+#define IPC_CONF_SLAB_16 8
+#endif
+
+#ifndef IPC_CONF_SLAB_32
+#define IPC_CONF_SLAB_32 4
+#endif
+
+#ifndef IPC_CONF_SLAB_64
+#define IPC_CONF_SLAB_64 2
+#endif
+
+#ifndef IPC_CONF_SLAB_128
+#define IPC_CONF_SLAB_128 1
+#endif
+
+/* Request/response calls over ipc_msg_t (ipc_call/ipc_reply, see sys/ipc/rpc.h).
+ * Adds a correlation id to every ipc_msg_t.
+ */
+#ifndef IPC_CONF_RPC
+#define IPC_CONF_RPC 0
+#endif
+
+/* Calls that can be outstanding at the same time (system wide) */
+#ifndef IPC_CONF_RPC_PENDING
+#define IPC_CONF_RPC_PENDING 4
+#endif
+
+/* Publish/subscribe bus (ipc_bus_publish/subscribe, see sys/ipc/bus.h).
+ * Needs IPC_CONF_MSG_REFCOUNT.
+ */
+#ifndef IPC_CONF_BUS
+#define IPC_CONF_BUS 0
+#endif
+
+/* Number of topics (ids 0 .. IPC_CONF_BUS_TOPICS - 1) */
+#ifndef IPC_CONF_BUS_TOPICS
+#define IPC_CONF_BUS_TOPICS 8
+#endif
+
+/* Processes that can subscribe at the same time (at most 32) */
+#ifndef IPC_CONF_BUS_SUBSCRIBERS
+#define IPC_CONF_BUS_SUBSCRIBERS 8
+#endif
+
+/* Keep the last message of every topic for late subscribers */
+#ifndef IPC_CONF_BUS_LATEST
+#define IPC_CONF_BUS_LATEST 1
+#endif
+
+/* Timestamped IPC (ipc_msg_age, ipc_pipe_age, process_event_age and the
+ * latency histograms of sys/ipc/latency.h). Message allocations, pipe writes
+ * into an empty pipe and posts record clock_time(). Costs 4 bytes per
+ * message and pipe, and a stamp and a source pointer per queued event.
+ */
+#ifndef IPC_CONF_TIMESTAMP
+#define IPC_CONF_TIMESTAMP 0
+#endif
+
+/* Source/destination paths that get a latency histogram */
+#ifndef IPC_CONF_LATENCY_PATHS
+#define IPC_CONF_LATENCY_PATHS 8
+#endif
+
+/* Buckets per histogram. Bucket i counts latencies below
+ * 2^(IPC_CONF_LATENCY_SHIFT + i) clock ticks, the last bucket all others.
+ */
+#ifndef IPC_CONF_LATENCY_BUCKETS
+#define IPC_CONF_LATENCY_BUCKETS 8
+#endif
+
+#ifndef IPC_CONF_LATENCY_SHIFT
+#define IPC_CONF_LATENCY_SHIFT 6
+#endif
+
+/* Shared-memory pipes between host processes (sys/ipc/shmpipe.h, POSIX
+ * shm_open/mmap; not AVR). Used to bridge a host build to a simulator.
+ */
+#ifndef IPC_CONF_SHM_PIPE
+#define IPC_CONF_SHM_PIPE 0
+#endif
+
 #endif
@@ -30,6 +30,14 @@
 extern "C" {
 #endif
 
+/* wake callback type used to notify scheduler/reader that data arrived.
+ * Example: for protoduino, your callback may call process_poll(reader_proc) or
+ * process_post(reader_proc, PROCESS_EVENT_POLL, NULL).
+ * The same type is used for signal callbacks, which fire on every change of a
+ * pool or pipe; process_cond_signal() from process.h fits this type.
+ */
+typedef void (*ipc_wake_cb_t)(void *ctx);
+
 /* ---------------------------------------------------------------------------
  * Message (packet) API
  * -------------------------------------------------------------------------*/
@@ -39,8 +47,42 @@ typedef struct ipc_msg {
     uint8_t type;                         /* application / subsystem message type */
     uint8_t argc;                         /* number of valid argv[] entries (0..IPC_MSG_MAX_ARGS) */
     void *argv[IPC_MSG_MAX_ARGS];         /* argument payload pointers (caller-allocated or pool) */
+#if IPC_CONF_MSG_REFCOUNT
+    uint8_t refs;                         /* references held; 0 = not reference counted */
+    struct ipc_pool *pool;                /* pool the message returns to on last release */
+#endif
+#if IPC_CONF_RPC
+    uint16_t call_id;                     /* correlation id set by ipc_call(); 0 = not a call */
+#endif
+#if IPC_CONF_TIMESTAMP
+    uint32_t stamp;                       /* clock_time() of the allocation, see ipc_msg_age() */
+#endif
 } ipc_msg_t;
 
+#if IPC_CONF_POOL_LOCKFREE
+#if defined(__AVR__)
+#error "IPC_CONF_POOL_LOCKFREE is for multi-threaded host builds only"
+#endif
+#if IPC_CONF_POOL_STATS
+#error "IPC_CONF_POOL_LOCKFREE cannot be combined with IPC_CONF_POOL_STATS"
+#endif
+#endif
+
+#if IPC_CONF_POOL_STATS
+/* Pool statistics, see ipc_pool_get_stats() */
+struct ipc_pool_stats {
+    uint16_t n_blocks;    /* total blocks */
+    uint16_t free_count;  /* blocks free now */
+    uint16_t min_free;    /* lowest free_count since init or reset */
+    uint32_t allocs;      /* successful ipc_pool_alloc() calls */
+    uint32_t frees;       /* ipc_pool_free() calls */
+    uint32_t fails;       /* ipc_pool_alloc() calls that found the pool empty */
+    uint32_t timed;       /* frees of blocks with a known alloc time */
+    uint64_t held_total;  /* sum of the times those blocks were outstanding */
+    uint32_t held_max;    /* longest time a block was outstanding */
+};
+#endif
+
 /* Message pool is the same fixed-block pool used by other users (opaque view) */
 struct ipc_pool {
     void *free_list;      /* pointer to first free block (stored inside blocks) */
@@ -48,6 +90,21 @@ struct ipc_pool {
     size_t block_size;    /* size of each block (>= sizeof(void*)) */
     uint16_t n_blocks;    /* total blocks */
     uint16_t free_count;  /* number free */
+#if IPC_CONF_SIGNAL
+    ipc_wake_cb_t signal_cb; /* called after every free (may be NULL) */
+    void *signal_ctx;        /* context passed to signal_cb */
+#endif
+#if IPC_CONF_POOL_OWNER
+    uint8_t *owners;         /* owner id per block, NULL when not tracked */
+    struct ipc_pool *next_tracked; /* next pool in the list of tracked pools */
+#endif
+#if IPC_CONF_POOL_STATS
+    struct ipc_pool_stats stats; /* counters (n_blocks/free_count filled on query) */
+    uint32_t *stamps;        /* clock_time() of the alloc per block, NULL when not timed */
+#endif
+#if IPC_CONF_POOL_LOCKFREE
+    uint64_t lf_head;        /* free stack: (tag << 32) | (count << 16) | (index + 1) of the top block */
+#endif
 };
 
 /* Initialize an ipc pool. buffer must be BLOCK_SIZE * N large.
@@ -61,9 +118,98 @@ void *ipc_pool_alloc(struct ipc_pool *p);
 /* Free a previously allocated block back to pool (no-op for NULL) */
 void ipc_pool_free(struct ipc_pool *p, void *blk);
 
-/* Number of free blocks currently available */
+/* Number of free blocks currently available (a snapshot with the lock-free backend) */
 uint16_t ipc_pool_count_free(struct ipc_pool *p);
 
+#if IPC_CONF_SIGNAL
+/* Set a callback that is invoked after every ipc_pool_free(), outside the
+ * atomic block. Use it to signal a condition object that allocators wait on,
+ * e.g. ipc_pool_set_signal(&pool, process_cond_signal, &pool_cond).
+ */
+void ipc_pool_set_signal(struct ipc_pool *p, ipc_wake_cb_t cb, void *ctx);
+#endif
+
+#if IPC_CONF_POOL_LOCKFREE
+/* Lock-free backend (host only).
+ *
+ * ipc_pool_alloc() and ipc_pool_free() may be called from any number of
+ * threads at once. Each of the first IPC_CONF_POOL_MAG_THREADS threads
+ * keeps a magazine of up to IPC_CONF_POOL_MAG_SIZE blocks for each of up to
+ * IPC_CONF_POOL_MAG_POOLS pools; only an empty or full magazine touches the
+ * shared free stack. free_count is not kept up to date; use
+ * ipc_pool_count_free(), which adds the blocks on the stack to the blocks
+ * cached in magazines. An allocation can fail while that count is > 0 when
+ * the remaining blocks sit in the magazines of other threads.
+ *
+ * A thread must call ipc_pool_thread_flush() before it exits, and every
+ * thread before a pool it used is initialized again.
+ */
+void ipc_pool_thread_flush(void);
+#endif
+
+#if IPC_CONF_POOL_STATS
+/* Pool instrumentation.
+ *
+ * Every pool counts allocations, frees and failed allocations and keeps the
+ * lowest number of free blocks seen. ipc_pool_stats_time() additionally
+ * records the clock_time() of every allocation in stamps (p->n_blocks
+ * entries), so frees add up how long blocks were outstanding.
+ * Times are in clock ticks (microseconds on AVR).
+ */
+int ipc_pool_stats_time(struct ipc_pool *p, uint32_t *stamps);
+
+/* Copy the statistics of p. Returns ERR_SUCCESS or ERR_HANDLE_NULL. */
+int ipc_pool_get_stats(const struct ipc_pool *p, struct ipc_pool_stats *st);
+
+/* Restart the counters; min_free starts at the current free count */
+void ipc_pool_stats_reset(struct ipc_pool *p);
+
+/* Print the statistics of p as one line on serial0, e.g.
+ * ipc_pool_stats_dump(&g_sys_msg_pool, "sys");
+ */
+void ipc_pool_stats_dump(const struct ipc_pool *p, const char *name);
+#endif
+
+#if IPC_CONF_POOL_OWNER
+/* Owner tracking.
+ *
+ * A tracked pool records a one byte owner id per block. ipc_pool_alloc()
+ * stamps a block with ipc_owner_current, which the scheduler sets to the id
+ * of the running process (IPC_OWNER_NONE outside processes), and
+ * ipc_pool_free() clears it. The scheduler moves ownership of a message to
+ * its receiver on a directed post and on delivery, and on process_exit()
+ * frees every block the process still owns with ipc_owner_reclaim().
+ *
+ * Blocks owned by IPC_OWNER_NONE are never reclaimed. Blocks allocated by an
+ * ISR while a process runs are stamped with that process; an ISR that keeps
+ * such a block should hand it to IPC_OWNER_NONE with ipc_owner_set().
+ */
+#define IPC_OWNER_NONE      0     /* kernel, ISRs and messages in flight */
+#define IPC_OWNER_UNTRACKED 0xFF  /* returned for blocks outside tracked pools */
+
+/* Owner id that ipc_pool_alloc() stamps on new blocks */
+extern uint8_t ipc_owner_current;
+
+/* Start tracking the owners of pool p. owners must hold p->n_blocks bytes.
+ * Call after ipc_pool_init(), while no blocks are allocated.
+ * Returns ERR_SUCCESS or ERR_HANDLE_NULL.
+ */
+int ipc_pool_track(struct ipc_pool *p, uint8_t *owners);
+
+/* Set the owner of a block of a tracked pool.
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL or ERR_MEM_BOUNDS when blk is not in a tracked pool.
+ */
+int ipc_owner_set(const void *blk, uint8_t owner);
+
+/* Owner of a block, or IPC_OWNER_UNTRACKED when blk is not in a tracked pool */
+uint8_t ipc_owner_get(const void *blk);
+
+/* Free every block of every tracked pool owned by owner (not IPC_OWNER_NONE).
+ * Returns the number of blocks freed.
+ */
+uint16_t ipc_owner_reclaim(uint8_t owner);
+#endif
+
 /* Message helpers using the ipc pool:
  * - ipc_msg_alloc_from_pool(pool) returns ipc_msg_t* or NULL
  * - ipc_msg_free_to_pool(pool, msg)
@@ -71,6 +217,30 @@ uint16_t ipc_pool_count_free(struct ipc_pool *p);
 ipc_msg_t *ipc_msg_alloc_from_pool(struct ipc_pool *pool);
 void ipc_msg_free_to_pool(struct ipc_pool *pool, ipc_msg_t *m);
 
+#if IPC_CONF_MSG_REFCOUNT
+/* Reference-counted messages.
+ *
+ * ipc_msg_alloc_shared(pool) returns a message holding one reference, owned
+ * by the caller. Posting it as PROCESS_EVENT_MSG hands that reference to the
+ * scheduler (when process_post() fails the caller still owns it). On
+ * delivery the scheduler retains the message once per receiver and releases
+ * it after each receiver's call, so one allocation serves any number of
+ * receivers and is freed after the last one. A handler that keeps the
+ * message beyond its call must ipc_msg_retain() it and ipc_msg_release() it
+ * later; it must not free it.
+ *
+ * Messages from ipc_msg_alloc_from_pool() and messages in static storage have
+ * refs == 0 and are delivered as before (the receiver frees them).
+ *
+ * Both calls are ISR-safe. The last ipc_msg_release() returns the message to
+ * its pool. They return ERR_SUCCESS, ERR_HANDLE_NULL, ERR_REF_ZERO for a
+ * message that is not (or no longer) reference counted, or ERR_REF_MAX.
+ */
+ipc_msg_t *ipc_msg_alloc_shared(struct ipc_pool *pool);
+int ipc_msg_retain(ipc_msg_t *m);
+int ipc_msg_release(ipc_msg_t *m);
+#endif
+
 /* Initialize message contents: sets type/argc and copies argv pointers (no deep copy) */
 int ipc_msg_init(ipc_msg_t *m, uint8_t type, uint8_t argc, void *argv[]);
 
@@ -81,12 +251,6 @@ int ipc_msg_set_arg(ipc_msg_t *m, uint8_t idx, void *arg);
  * Pipe (stream) API
  * -------------------------------------------------------------------------*/
 
-/* wake callback type used to notify scheduler/reader that data arrived.
- * Example: for protoduino, your callback may call process_poll(reader_proc) or
- * process_post(reader_proc, PROCESS_EVENT_POLL, NULL).
- */
-typedef void (*ipc_wake_cb_t)(void *ctx);
-
 typedef struct ipc_pipe {
     uint8_t *buf;             /* pointer to buffer storage */
     size_t size;              /* total buffer size in bytes (must be >= 2) */
@@ -94,6 +258,21 @@ typedef struct ipc_pipe {
     size_t tail;              /* read index (next read position) */
     ipc_wake_cb_t wake_cb;    /* callback to notify reader (may be NULL) */
     void *wake_ctx;           /* context passed to callback */
+#if IPC_CONF_SIGNAL
+    ipc_wake_cb_t signal_cb;  /* called after every write or read that moved bytes (may be NULL) */
+    void *signal_ctx;         /* context passed to signal_cb */
+#endif
+#if IPC_CONF_PIPE_SPACE
+    ipc_wake_cb_t space_cb;   /* callback to notify writer (may be NULL) */
+    void *space_ctx;          /* context passed to space_cb */
+    size_t space_low;         /* low watermark: space_cb fires when free space rises to it */
+#endif
+#if IPC_CONF_PIPE_SPSC
+    size_t mask;              /* size - 1 in SPSC mode, 0 otherwise */
+#endif
+#if IPC_CONF_TIMESTAMP
+    uint32_t stamp;           /* clock_time() when the pipe last became non-empty */
+#endif
 } ipc_pipe_t;
 
 /* Initialize a pipe. buffer must be `size` bytes. wake_cb may be NULL.
@@ -101,6 +280,19 @@ typedef struct ipc_pipe {
  */
 int ipc_pipe_init(ipc_pipe_t *p, void *buffer, size_t size, ipc_wake_cb_t wake_cb, void *wake_ctx);
 
+#if IPC_CONF_PIPE_SPSC
+/* Initialize a lock-free single-producer/single-consumer pipe.
+ * size must be a power of two (and at most 256 on AVR). Indices wrap with a
+ * mask instead of a division, and head/tail are published with release
+ * stores and read with acquire loads (C11 atomics on the host), so neither
+ * side disables interrupts. Exactly one context may write (e.g. an ISR) and
+ * exactly one may read (e.g. a process); ipc_pipe_clear() must be called by
+ * the reader. All pipe functions work on both kinds of pipe.
+ * Returns ERR_SUCCESS, ERR_VAL_RANGE for a bad size or ERR_PROC_INVAL.
+ */
+int ipc_pipe_init_spsc(ipc_pipe_t *p, void *buffer, size_t size, ipc_wake_cb_t wake_cb, void *wake_ctx);
+#endif
+
 /* Query available bytes in pipe (reader-visible) */
 size_t ipc_pipe_available(const ipc_pipe_t *p);
 
@@ -117,9 +309,108 @@ size_t ipc_pipe_write(ipc_pipe_t *p, const uint8_t *src, size_t len);
 /* Read up to len bytes from pipe into dst. Returns number of bytes read (may be 0). */
 size_t ipc_pipe_read(ipc_pipe_t *p, uint8_t *dst, size_t len);
 
+/* Scatter/gather I/O.
+ *
+ * ipc_pipe_writev() writes the n buffers of iov as one unit, e.g. header,
+ * payload and CRC of a frame: either all bytes fit and are placed in one
+ * atomic section, or nothing is written. A reader therefore never sees part
+ * of the unit, and the reader is woken at most once. ipc_pipe_readv() fills
+ * the n buffers of iov only when all of their bytes are available.
+ * Both return the number of bytes moved, the sum of the iov lengths or 0.
+ */
+typedef struct ipc_iovec {
+    void *base;               /* buffer */
+    size_t len;               /* bytes in it */
+} ipc_iovec_t;
+
+size_t ipc_pipe_writev(ipc_pipe_t *p, const ipc_iovec_t *iov, uint8_t n);
+size_t ipc_pipe_readv(ipc_pipe_t *p, const ipc_iovec_t *iov, uint8_t n);
+
+/* Ring-to-ring copies.
+ *
+ * ipc_pipe_splice() moves up to max bytes from src to dst without a buffer
+ * in between: every contiguous chunk (up to the end of either ring) is
+ * copied once, in one atomic section that also advances both indices.
+ * ipc_pipe_tee() copies the same way but leaves the bytes in src, so src can
+ * still be read or spliced elsewhere. Both return the bytes copied, bounded
+ * by max, the data in src and the free space of dst. The callbacks of dst
+ * (and for splice those of src) fire at most once per call.
+ * ipc_pipe_splice_ringb8() splices into a ringb8 such as a serial TX buffer;
+ * use serial[0..3]_splice(), which also starts the transmitter.
+ */
+struct ringb8_t;
+
+size_t ipc_pipe_splice(ipc_pipe_t *dst, ipc_pipe_t *src, size_t max);
+size_t ipc_pipe_tee(ipc_pipe_t *dst, ipc_pipe_t *src, size_t max);
+size_t ipc_pipe_splice_ringb8(struct ringb8_t *dst, ipc_pipe_t *src, size_t max);
+
+/* Zero-copy span API.
+ *
+ * ipc_pipe_write_reserve() returns in *ptr and *len the largest contiguous free
+ * span at the write position (*len is 0 when the pipe is full). The writer
+ * fills up to *len bytes in place and publishes them with
+ * ipc_pipe_write_commit(p, n). Commit wakes the reader like ipc_pipe_write().
+ *
+ * ipc_pipe_read_peek() returns in *ptr and *len the largest contiguous readable
+ * span at the read position (*len is 0 when the pipe is empty). The reader
+ * looks at the bytes in place and releases them with ipc_pipe_read_consume(p, n).
+ *
+ * A span ends at the end of the buffer; when the data wraps, call peek or
+ * reserve again after consuming or committing the first span. Only the index
+ * updates are atomic, the bytes are never copied by the pipe. A span API user
+ * must be the only writer (reserve/commit) or the only reader (peek/consume)
+ * of the pipe while it holds a span.
+ *
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL on NULL args, or ERR_VAL_RANGE when
+ * n is larger than the free span (commit) or the available bytes (consume).
+ */
+int ipc_pipe_write_reserve(ipc_pipe_t *p, uint8_t **ptr, size_t *len);
+int ipc_pipe_write_commit(ipc_pipe_t *p, size_t n);
+int ipc_pipe_read_peek(ipc_pipe_t *p, const uint8_t **ptr, size_t *len);
+int ipc_pipe_read_consume(ipc_pipe_t *p, size_t n);
+
 /* Clear pipe (drop contents) */
 void ipc_pipe_clear(ipc_pipe_t *p);
 
+#if IPC_CONF_SIGNAL
+/* Set a callback that is invoked after every write and read that moved bytes,
+ * outside the atomic block. Unlike wake_cb it also fires when data is added to
+ * a non-empty pipe and when space is freed, so both readers waiting for N bytes
+ * and writers waiting for space can wait on one condition object, e.g.
+ * ipc_pipe_set_signal(&pipe, process_cond_signal, &pipe_cond).
+ */
+void ipc_pipe_set_signal(ipc_pipe_t *p, ipc_wake_cb_t cb, void *ctx);
+#endif
+
+#if IPC_CONF_PIPE_SPACE
+/* Set a writer-side callback for backpressure. It is invoked, outside the
+ * atomic block, by ipc_pipe_read(), ipc_pipe_read_consume() and
+ * ipc_pipe_clear() when the free space rises from below low_watermark to
+ * low_watermark or more. Like wake_cb it is edge triggered: a writer that got
+ * a short write left the pipe full, so the next crossing is guaranteed to be
+ * reported. Use a callback that latches, e.g. process_poll, so a wakeup that
+ * arrives before the writer waits is not lost. low_watermark is clamped to
+ * 1..size-1.
+ */
+void ipc_pipe_set_space(ipc_pipe_t *p, ipc_wake_cb_t cb, void *ctx, size_t low_watermark);
+#endif
+
+#if IPC_CONF_TIMESTAMP
+/* Timestamps.
+ *
+ * Messages from a pool carry the clock_time() of their allocation; an ISR
+ * that allocates the message for a sample therefore starts the clock of the
+ * whole path. ipc_msg_age() is the time since then, and ipc_msg_stamp()
+ * restarts it (e.g. for static messages). A pipe records when a write made
+ * it non-empty; ipc_pipe_age() is the time since then, an upper bound for the
+ * age of the oldest unread byte, or 0 when the pipe is empty.
+ * Times are in clock ticks (microseconds on AVR).
+ */
+uint32_t ipc_msg_age(const ipc_msg_t *m);
+void ipc_msg_stamp(ipc_msg_t *m);
+uint32_t ipc_pipe_age(const ipc_pipe_t *p);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
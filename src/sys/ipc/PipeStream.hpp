@@ -0,0 +1,88 @@
+// file: ./src/sys/ipc/PipeStream.hpp
+
+#ifndef __PipeStream_HPP__
+#define __PipeStream_HPP__
+#include "Stream.h"
+#include "../ipc.h"
+
+/**
+ * @brief Arduino Stream adapter for an ipc_pipe
+ *
+ * @details
+ * PipeStream lets code written against the Arduino `Stream` API (utf8_getr(), utf8_putr(), Print::print(), ...)
+ * read from and write to an ipc_pipe directly, without copying the data into an intermediate stream object.
+ * Like SerialClass.hpp it is a thin layer over the C99 functions: available() and availableForWrite() map to
+ * ipc_pipe_available() and ipc_pipe_space(), peek() looks at the read span in place (ipc_pipe_read_peek()), and
+ * read(), write(), readBytes() and write(buf, size) move bytes with ipc_pipe_read() and ipc_pipe_write().
+ * The bulk calls copy a whole run of bytes in one atomic section and wake the other side once, instead of
+ * once per byte.
+ *
+ * The class is final. Code that holds a `PipeStream *` (rather than a `Stream *`) calls its methods without
+ * going through the vtable, so the compiler can inline them. The template overloads of utf8_getr() and
+ * utf8_putr() in utf8-stream.h are picked for such pointers automatically.
+ *
+ * @code
+ * static uint8_t rx_buffer[64];
+ * static ipc_pipe_t rx_pipe;
+ * static PipeStream rx(&rx_pipe);
+ *
+ * ipc_pipe_init(&rx_pipe, rx_buffer, sizeof(rx_buffer), NULL, NULL);
+ * ...
+ * rune16_t r;
+ * while (utf8_getr(&rx, &r) > 0) { ... }  // non-virtual decode path
+ * @endcode
+ *
+ * @note
+ * A pipe is filled and drained by other processes and ISRs, which cannot make progress while a caller
+ * blocks. Unlike Stream::readBytes() and Serial0Class::write(), PipeStream never waits: readBytes() returns
+ * the bytes that are there and write() what fitted. Wait for the pipe in the calling process instead
+ * (wake_cb or ipc_pipe_set_space()).
+ *
+ * @warning
+ * peek() uses the span API; the stream must then be the only reader of the pipe (see ipc.h).
+ */
+
+class PipeStream final : public Stream
+{
+
+  public:
+    inline PipeStream(ipc_pipe_t *pipe) : _pipe(pipe) { }
+
+    inline ipc_pipe_t *pipe(void) { return _pipe; }
+
+    inline int available(void) { return (int)ipc_pipe_available(_pipe); }
+
+    inline int peek(void)
+    {
+      const uint8_t *ptr;
+      size_t len;
+      ipc_pipe_read_peek(_pipe, &ptr, &len);
+      return len > 0 ? *ptr : -1;
+    }
+
+    inline int read(void)
+    {
+      uint8_t c;
+      return ipc_pipe_read(_pipe, &c, 1) == 1 ? c : -1;
+    }
+
+    inline size_t readBytes(uint8_t *buffer, size_t length) { return ipc_pipe_read(_pipe, buffer, length); }
+    inline size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+
+    inline void flush(void) { } // the reader drains the pipe, nothing to push
+
+    inline int availableForWrite(void) { return (int)ipc_pipe_space(_pipe); }
+
+    inline size_t write(const uint8_t n) { return ipc_pipe_write(_pipe, &n, 1); }
+    inline size_t write(const uint8_t *buffer, size_t size) { return ipc_pipe_write(_pipe, buffer, size); }
+
+    using Print::write; // pull in write(str) and write(char *, size) from Print
+
+    operator bool() { return _pipe != NULL; }
+
+  private:
+    ipc_pipe_t *_pipe;
+
+};
+
+#endif
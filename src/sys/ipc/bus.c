@@ -0,0 +1,186 @@
+// file: ./src/sys/ipc/bus.c
+
+#include "bus.h"
+
+#if IPC_CONF_BUS
+
+/* -------------------------------------------------------------------------
+ * Bus state. Bit i of a topic mask stands for the process in bus_subs[i];
+ * an entry of bus_subs is free when no topic has its bit set. Subscriptions
+ * are changed in one atomic section each, so a publish from an ISR always
+ * sees a mask whose bits point at valid processes.
+ * ----------------------------------------------------------------------*/
+
+static struct process *bus_subs[IPC_CONF_BUS_SUBSCRIBERS];
+
+static struct {
+    ipc_bus_mask_t subs;          /* subscribers of this topic */
+    uint16_t dropped;             /* deliveries lost to full queues */
+#if IPC_CONF_BUS_LATEST
+    ipc_msg_t *latest;            /* last message, holds one reference */
+#endif
+} bus_topics[IPC_CONF_BUS_TOPICS];
+
+/* Post msg to p with a reference of its own; false when it was not delivered */
+static bool bus_deliver(struct process *p, ipc_msg_t *msg)
+{
+    if (ipc_msg_retain(msg) != ERR_SUCCESS) return false;
+    if (process_post(p, PROCESS_EVENT_MSG, msg)) return true;
+    ipc_msg_release(msg);
+    return false;
+}
+
+/* Free the entry of subscriber i when no topic uses it (caller must ensure atomic) */
+static void bus_free_sub_nolock(uint8_t i)
+{
+    ipc_bus_mask_t bit = (ipc_bus_mask_t)1 << i;
+    for (uint8_t t = 0; t < IPC_CONF_BUS_TOPICS; ++t) {
+        if (bus_topics[t].subs & bit) return;
+    }
+    bus_subs[i] = NULL;
+}
+
+int ipc_bus_publish(uint8_t topic, ipc_msg_t *msg)
+{
+    if (!msg) return ERR_HANDLE_NULL;
+    if (msg->refs == 0) return ERR_REF_ZERO;
+    if (topic >= IPC_CONF_BUS_TOPICS) {
+        ipc_msg_release(msg);
+        return ERR_VAL_RANGE;
+    }
+    msg->type = topic;
+
+    ipc_bus_mask_t mask;
+    CC_ATOMIC_RESTORE() {
+        mask = bus_topics[topic].subs;
+    }
+
+    uint16_t lost = 0;
+    for (uint8_t i = 0; mask != 0; ++i, mask >>= 1) {
+        if ((mask & 1) && !bus_deliver(bus_subs[i], msg)) lost++;
+    }
+
+#if IPC_CONF_BUS_LATEST
+    ipc_msg_t *old = NULL;
+    if (ipc_msg_retain(msg) == ERR_SUCCESS) {
+        CC_ATOMIC_RESTORE() {
+            old = bus_topics[topic].latest;
+            bus_topics[topic].latest = msg;
+        }
+    }
+    if (old) ipc_msg_release(old);
+#endif
+
+    if (lost > 0) {
+        CC_ATOMIC_RESTORE() {
+            bus_topics[topic].dropped += lost;
+        }
+    }
+
+    /* the reference of the publisher */
+    ipc_msg_release(msg);
+    return ERR_SUCCESS;
+}
+
+int ipc_bus_subscribe(uint8_t topic, struct process *p)
+{
+    if (!p) return ERR_HANDLE_NULL;
+    if (topic >= IPC_CONF_BUS_TOPICS) return ERR_VAL_RANGE;
+
+    int ret = ERR_BOUNDS_UPPER;
+#if IPC_CONF_BUS_LATEST
+    ipc_msg_t *latest = NULL;
+#endif
+    CC_ATOMIC_RESTORE() {
+        uint8_t i, spare = IPC_CONF_BUS_SUBSCRIBERS;
+        for (i = 0; i < IPC_CONF_BUS_SUBSCRIBERS; ++i) {
+            if (bus_subs[i] == p) break;
+            if (bus_subs[i] == NULL && spare == IPC_CONF_BUS_SUBSCRIBERS) spare = i;
+        }
+        if (i == IPC_CONF_BUS_SUBSCRIBERS) i = spare;
+        if (i < IPC_CONF_BUS_SUBSCRIBERS) {
+            ipc_bus_mask_t bit = (ipc_bus_mask_t)1 << i;
+            bus_subs[i] = p;
+#if IPC_CONF_BUS_LATEST
+            /* take a reference before a publish from an ISR can drop the cached one */
+            if (!(bus_topics[topic].subs & bit)) latest = bus_topics[topic].latest;
+            if (latest && ipc_msg_retain(latest) != ERR_SUCCESS) latest = NULL;
+#endif
+            bus_topics[topic].subs |= bit;
+            ret = ERR_SUCCESS;
+        }
+    }
+
+#if IPC_CONF_BUS_LATEST
+    if (latest && !process_post(p, PROCESS_EVENT_MSG, latest)) {
+        ipc_msg_release(latest);
+        CC_ATOMIC_RESTORE() {
+            bus_topics[topic].dropped++;
+        }
+    }
+#endif
+    return ret;
+}
+
+void ipc_bus_unsubscribe(uint8_t topic, struct process *p)
+{
+    if (!p || topic >= IPC_CONF_BUS_TOPICS) return;
+    CC_ATOMIC_RESTORE() {
+        for (uint8_t i = 0; i < IPC_CONF_BUS_SUBSCRIBERS; ++i) {
+            if (bus_subs[i] != p) continue;
+            bus_topics[topic].subs &= (ipc_bus_mask_t)~((ipc_bus_mask_t)1 << i);
+            bus_free_sub_nolock(i);
+            break;
+        }
+    }
+}
+
+void ipc_bus_drop_process(struct process *p)
+{
+    if (!p) return;
+    CC_ATOMIC_RESTORE() {
+        for (uint8_t i = 0; i < IPC_CONF_BUS_SUBSCRIBERS; ++i) {
+            if (bus_subs[i] != p) continue;
+            ipc_bus_mask_t keep = (ipc_bus_mask_t)~((ipc_bus_mask_t)1 << i);
+            for (uint8_t t = 0; t < IPC_CONF_BUS_TOPICS; ++t) bus_topics[t].subs &= keep;
+            bus_subs[i] = NULL;
+            break;
+        }
+    }
+}
+
+uint16_t ipc_bus_dropped(uint8_t topic)
+{
+    if (topic >= IPC_CONF_BUS_TOPICS) return 0;
+    uint16_t n;
+    CC_ATOMIC_RESTORE() {
+        n = bus_topics[topic].dropped;
+    }
+    return n;
+}
+
+#if IPC_CONF_BUS_LATEST
+ipc_msg_t *ipc_bus_latest(uint8_t topic)
+{
+    if (topic >= IPC_CONF_BUS_TOPICS) return NULL;
+    ipc_msg_t *m;
+    CC_ATOMIC_RESTORE() {
+        m = bus_topics[topic].latest;
+        if (m && ipc_msg_retain(m) != ERR_SUCCESS) m = NULL;
+    }
+    return m;
+}
+
+void ipc_bus_clear(uint8_t topic)
+{
+    if (topic >= IPC_CONF_BUS_TOPICS) return;
+    ipc_msg_t *old;
+    CC_ATOMIC_RESTORE() {
+        old = bus_topics[topic].latest;
+        bus_topics[topic].latest = NULL;
+    }
+    if (old) ipc_msg_release(old);
+}
+#endif
+
+#endif /* IPC_CONF_BUS */
@@ -0,0 +1,91 @@
+// file: ./src/sys/ipc/bus.h
+#ifndef __IPC_BUS_H__
+#define __IPC_BUS_H__ 1
+
+/* Publish/subscribe bus on top of reference-counted messages.
+ *
+ * Producers publish messages on numbered topics; every process subscribed
+ * to a topic receives the message as PROCESS_EVENT_MSG with msg->type set
+ * to the topic id. A publish allocates nothing: the one message from
+ * ipc_msg_alloc_shared() is posted to all subscribers with one reference
+ * each, and the scheduler releases a reference after every delivery.
+ *
+ * The subscribers of a topic are a bitmap over a small table of subscribing
+ * processes, so the cost of a publish grows with the number of subscribers,
+ * not with the number of processes. With IPC_CONF_BUS_LATEST every topic
+ * keeps a reference to its last message, and a new subscriber receives it
+ * right away.
+ *
+ *   ipc_msg_t *m = ipc_msg_alloc_shared(&g_sys_msg_pool);
+ *   ipc_msg_set_arg(m, 0, (void*)(uintptr_t)temperature);
+ *   ipc_bus_publish(TOPIC_TEMP, m);      // the bus takes the reference
+ *
+ * Subscribers must not modify a message; it is shared. A subscriber that
+ * keeps a message beyond its call must ipc_msg_retain() it.
+ */
+
+#include "../ipc.h"
+#include "../process.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if IPC_CONF_BUS
+
+#if !IPC_CONF_MSG_REFCOUNT
+#error "IPC_CONF_BUS needs IPC_CONF_MSG_REFCOUNT"
+#endif
+
+#if IPC_CONF_BUS_SUBSCRIBERS <= 8
+typedef uint8_t ipc_bus_mask_t;
+#elif IPC_CONF_BUS_SUBSCRIBERS <= 16
+typedef uint16_t ipc_bus_mask_t;
+#elif IPC_CONF_BUS_SUBSCRIBERS <= 32
+typedef uint32_t ipc_bus_mask_t;
+#else
+#error "IPC_CONF_BUS_SUBSCRIBERS must not exceed 32"
+#endif
+
+/* Publish msg on topic. msg must come from ipc_msg_alloc_shared(); the
+ * caller's reference passes to the bus, also when an error is returned.
+ * Subscribers whose event queue is full miss the message (counted by
+ * ipc_bus_dropped()). Safe to call from ISR.
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL, ERR_VAL_RANGE for a bad topic or
+ * ERR_REF_ZERO when msg is not reference counted (msg is left alone).
+ */
+int ipc_bus_publish(uint8_t topic, ipc_msg_t *msg);
+
+/* Subscribe process p to topic; with IPC_CONF_BUS_LATEST the last message
+ * of the topic is posted to p at once.
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL, ERR_VAL_RANGE or ERR_BOUNDS_UPPER
+ * when IPC_CONF_BUS_SUBSCRIBERS processes subscribe already.
+ */
+int ipc_bus_subscribe(uint8_t topic, struct process *p);
+
+/* Remove the subscription of p to topic (no-op when not subscribed) */
+void ipc_bus_unsubscribe(uint8_t topic, struct process *p);
+
+/* Remove every subscription of p; process_exit() calls this */
+void ipc_bus_drop_process(struct process *p);
+
+/* Deliveries of topic lost to full event queues since init */
+uint16_t ipc_bus_dropped(uint8_t topic);
+
+#if IPC_CONF_BUS_LATEST
+/* The last message published on topic with one reference for the caller,
+ * who must ipc_msg_release() it; NULL when nothing was published yet.
+ */
+ipc_msg_t *ipc_bus_latest(uint8_t topic);
+
+/* Drop the cached message of topic */
+void ipc_bus_clear(uint8_t topic);
+#endif
+
+#endif /* IPC_CONF_BUS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IPC_BUS_H__ */
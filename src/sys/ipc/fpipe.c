@@ -0,0 +1,96 @@
+// file: ./src/sys/ipc/fpipe.c
+
+#include "fpipe.h"
+#include <string.h>
+
+/* -------------------------------------------------------------------------
+ * Framed pipe implementation. Built on the zero-copy span API of ipc_pipe,
+ * so it takes no locks of its own and works on locked and SPSC pipes.
+ * Headers are stored little endian.
+ * ----------------------------------------------------------------------*/
+
+static void put_hdr(uint8_t *w, uint16_t v)
+{
+    w[0] = (uint8_t)(v & 0xFF);
+    w[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get_hdr(const uint8_t *r)
+{
+    return (uint16_t)(r[0] | ((uint16_t)r[1] << 8));
+}
+
+int ipc_fpipe_init(ipc_fpipe_t *f, void *buffer, size_t size, ipc_wake_cb_t wake_cb, void *wake_ctx)
+{
+    if (!f) return ERR_PROC_INVAL;
+    if (size < IPC_FPIPE_HDR_SIZE + 1) return ERR_PROC_INVAL;
+    return ipc_pipe_init(&f->pipe, buffer, size, wake_cb, wake_ctx);
+}
+
+int ipc_fpipe_push(ipc_fpipe_t *f, const void *data, size_t len)
+{
+    if (!f || (!data && len > 0)) return ERR_HANDLE_NULL;
+    ipc_pipe_t *p = &f->pipe;
+    size_t need = IPC_FPIPE_HDR_SIZE + len;
+    if (need > p->size - 1 || len >= IPC_FPIPE_SKIP) return ERR_MSG_SIZE;
+
+    uint8_t *w;
+    size_t span;
+    ipc_pipe_write_reserve(p, &w, &span);
+
+    if (span < need) {
+        /* Only a span that runs up to the end of the buffer can be skipped;
+         * otherwise the reader is in the way. The space at the start is the
+         * total space minus the skipped end. The reader only ever frees more
+         * space, so the check stays valid until the record is committed.
+         */
+        size_t end = p->size - (size_t)(w - p->buf);
+        if (span != end) return ERR_PIPE_FULL;
+        bool fits = ipc_pipe_space(p) - end >= need;
+
+        /* The record must start at the beginning of the buffer in any case.
+         * Skip the end even when it does not fit there yet: once the reader
+         * has passed the skip, the whole buffer is free again. Otherwise a
+         * record larger than the free span at the end would never fit.
+         * Fewer than IPC_FPIPE_HDR_SIZE bytes at the end are skipped implicitly.
+         */
+        if (end >= IPC_FPIPE_HDR_SIZE) put_hdr(w, IPC_FPIPE_SKIP);
+        ipc_pipe_write_commit(p, end);
+        if (!fits) return ERR_PIPE_FULL;
+        ipc_pipe_write_reserve(p, &w, &span);
+    }
+
+    put_hdr(w, (uint16_t)len);
+    memcpy(w + IPC_FPIPE_HDR_SIZE, data, len);
+    return ipc_pipe_write_commit(p, need);
+}
+
+const void *ipc_fpipe_front(ipc_fpipe_t *f, size_t *len)
+{
+    if (!f || !len) return NULL;
+    ipc_pipe_t *p = &f->pipe;
+    const uint8_t *r;
+    size_t avail;
+
+    for (;;) {
+        ipc_pipe_read_peek(p, &r, &avail);
+        if (avail == 0) return NULL;
+
+        size_t end = p->size - (size_t)(r - p->buf);
+        if (end < IPC_FPIPE_HDR_SIZE || get_hdr(r) == IPC_FPIPE_SKIP) {
+            ipc_pipe_read_consume(p, end);
+            continue;
+        }
+        /* a record is committed at once, so it is complete when its header is visible */
+        *len = get_hdr(r);
+        return r + IPC_FPIPE_HDR_SIZE;
+    }
+}
+
+int ipc_fpipe_pop(ipc_fpipe_t *f)
+{
+    size_t len;
+    if (!f) return ERR_HANDLE_NULL;
+    if (ipc_fpipe_front(f, &len) == NULL) return ERR_VAL_RANGE;
+    return ipc_pipe_read_consume(&f->pipe, IPC_FPIPE_HDR_SIZE + len);
+}
@@ -0,0 +1,64 @@
+// file: ./src/sys/ipc/fpipe.h
+#ifndef __IPC_FPIPE_H__
+#define __IPC_FPIPE_H__ 1
+
+/* Framed pipe: variable-length records on top of ipc_pipe.
+ *
+ * Every record is stored contiguously in the ring as a 2 byte length header
+ * followed by the payload. A record never wraps: when it does not fit before
+ * the end of the buffer, the writer fills the end with a skip marker and
+ * stores the record at the start. The reader therefore always sees a whole
+ * record in place, and ipc_fpipe_front() returns a pointer into the ring
+ * (zero-copy). A packet is copied exactly once, by ipc_fpipe_push().
+ *
+ * Writes are all-or-nothing: a record is either stored completely or not at
+ * all. The wake, signal and space callbacks of the underlying pipe work as
+ * usual (set them on f->pipe). With IPC_CONF_PIPE_SPSC the pipe may also be
+ * initialized with ipc_pipe_init_spsc() for a lock-free
+ * single-producer/single-consumer pipe.
+ *
+ * There must be one writer (push) and one reader (front/pop) at a time.
+ */
+
+#include "../ipc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size of the record header in the ring */
+#define IPC_FPIPE_HDR_SIZE  2
+
+/* Header value that marks the rest of the buffer as unused */
+#define IPC_FPIPE_SKIP      0xFFFF
+
+typedef struct ipc_fpipe {
+    ipc_pipe_t pipe;          /* underlying byte ring */
+} ipc_fpipe_t;
+
+/* Initialize a framed pipe; same arguments as ipc_pipe_init(). The largest
+ * record holds size - 1 - IPC_FPIPE_HDR_SIZE bytes.
+ */
+int ipc_fpipe_init(ipc_fpipe_t *f, void *buffer, size_t size, ipc_wake_cb_t wake_cb, void *wake_ctx);
+
+/* Append one record of len bytes. All-or-nothing.
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL, ERR_MSG_SIZE when the record can never
+ * fit, or ERR_PIPE_FULL when there is no room for it right now. A record that
+ * has to wrap may already have skipped the end of the buffer on ERR_PIPE_FULL;
+ * it fits once the reader has caught up with the skip (ipc_fpipe_front()).
+ */
+int ipc_fpipe_push(ipc_fpipe_t *f, const void *data, size_t len);
+
+/* Return a pointer to the payload of the oldest record and its length in *len,
+ * or NULL when the pipe is empty. The record stays valid until ipc_fpipe_pop().
+ */
+const void *ipc_fpipe_front(ipc_fpipe_t *f, size_t *len);
+
+/* Remove the oldest record. Returns ERR_SUCCESS or ERR_VAL_RANGE when empty. */
+int ipc_fpipe_pop(ipc_fpipe_t *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IPC_FPIPE_H__ */
@@ -0,0 +1,180 @@
+// file: ./src/sys/ipc/graph.c
+
+#include "../ipc.h"
+
+#if IPC_CONF_PIPE_SPACE
+#include "graph.h"
+
+/* -------------------------------------------------------------------------
+ * Graph runtime. The topology is only looked at by ipc_graph_init(); at run
+ * time a stage is a list of ports whose fill levels decide whether it runs.
+ * All pipe accesses go through the public pipe API, so locked and SPSC
+ * pipes work alike and ISRs may feed the inputs at any time.
+ * ----------------------------------------------------------------------*/
+
+/* The byte ring behind a port */
+static ipc_pipe_t *port_pipe(const ipc_port_t *pt)
+{
+    return (pt->kind == IPC_PORT_FRAMES) ? &((ipc_fpipe_t*)pt->pipe)->pipe : (ipc_pipe_t*)pt->pipe;
+}
+
+/* Free bytes an output port needs before its stage may run */
+static size_t port_need(const ipc_port_t *pt)
+{
+    return (pt->kind == IPC_PORT_FRAMES) ? (size_t)pt->unit + IPC_FPIPE_HDR_SIZE : pt->unit;
+}
+
+static bool port_has_data(const ipc_port_t *pt)
+{
+    if (pt->kind == IPC_PORT_FRAMES) {
+        size_t len;
+        return ipc_fpipe_front((ipc_fpipe_t*)pt->pipe, &len) != NULL;
+    }
+    return ipc_pipe_available((ipc_pipe_t*)pt->pipe) >= pt->unit;
+}
+
+static bool port_has_space(const ipc_port_t *pt)
+{
+    return ipc_pipe_space(port_pipe(pt)) >= port_need(pt);
+}
+
+static bool stage_ready(const ipc_stage_t *s)
+{
+    for (uint8_t i = 0; i < s->n_in; ++i) {
+        if (!port_has_data(&s->in[i])) return false;
+    }
+    for (uint8_t i = 0; i < s->n_out; ++i) {
+        if (!port_has_space(&s->out[i])) return false;
+    }
+    return true;
+}
+
+static void graph_wake(void *ctx)
+{
+    process_poll((struct process*)ctx);
+}
+
+/* Check the ports of one direction on their own */
+static int check_ports(const ipc_port_t *ports, uint8_t n, bool out)
+{
+    if (n > 0 && !ports) return ERR_HANDLE_NULL;
+    for (uint8_t i = 0; i < n; ++i) {
+        const ipc_port_t *pt = &ports[i];
+        if (!pt->pipe) return ERR_HANDLE_NULL;
+        if (pt->kind != IPC_PORT_BYTES && pt->kind != IPC_PORT_FRAMES) return ERR_HANDLE_TYPE;
+        if (pt->kind == IPC_PORT_BYTES && pt->unit == 0) return ERR_HANDLE_TYPE;
+        if ((out || pt->kind == IPC_PORT_BYTES) && port_need(pt) > port_pipe(pt)->size - 1) return ERR_MSG_SIZE;
+    }
+    return ERR_SUCCESS;
+}
+
+/* Find the stage and port that use pipe in direction out, other than (skip_s, skip_p).
+ * Returns the stage index, or n when there is none.
+ */
+static uint8_t find_port(const ipc_graph_t *g, const void *pipe, bool out,
+                         uint8_t skip_s, uint8_t skip_p, const ipc_port_t **found)
+{
+    for (uint8_t j = 0; j < g->n; ++j) {
+        const ipc_stage_t *s = &g->stages[j];
+        const ipc_port_t *ports = out ? s->out : s->in;
+        uint8_t n = out ? s->n_out : s->n_in;
+        for (uint8_t k = 0; k < n; ++k) {
+            if (j == skip_s && k == skip_p) continue;
+            if (ports[k].pipe == pipe) {
+                *found = &ports[k];
+                return j;
+            }
+        }
+    }
+    return g->n;
+}
+
+int ipc_graph_init(ipc_graph_t *g, ipc_stage_t *stages, uint8_t n, struct process *runner)
+{
+    if (!g || (!stages && n > 0)) return ERR_HANDLE_NULL;
+    g->stages = stages;
+    g->n = n;
+    g->runner = runner;
+
+    for (uint8_t i = 0; i < n; ++i) {
+        const ipc_stage_t *s = &stages[i];
+        if (!s->run) return ERR_HANDLE_NULL;
+        int ret = check_ports(s->in, s->n_in, false);
+        if (ret == ERR_SUCCESS) ret = check_ports(s->out, s->n_out, true);
+        if (ret != ERR_SUCCESS) return ret;
+    }
+
+    /* every edge: one writer, one reader, same type, writer first */
+    for (uint8_t i = 0; i < n; ++i) {
+        const ipc_stage_t *s = &stages[i];
+        const ipc_port_t *other;
+        for (uint8_t k = 0; k < s->n_out; ++k) {
+            const ipc_port_t *pt = &s->out[k];
+            if (find_port(g, pt->pipe, true, i, k, &other) < n) return ERR_ACCESS_OWNER;
+            uint8_t j = find_port(g, pt->pipe, false, n, 0, &other);
+            if (j == n) continue;
+            if (other->kind != pt->kind) return ERR_HANDLE_TYPE;
+            if (pt->kind == IPC_PORT_BYTES && other->unit != pt->unit) return ERR_HANDLE_TYPE;
+            if (j <= i) return ERR_INIT_DEPENDENCY;
+        }
+        for (uint8_t k = 0; k < s->n_in; ++k) {
+            if (find_port(g, s->in[k].pipe, false, i, k, &other) < n) return ERR_ACCESS_OWNER;
+        }
+    }
+
+    if (!runner) return ERR_SUCCESS;
+
+    /* inputs poll the runner on data, outputs on space */
+    for (uint8_t i = 0; i < n; ++i) {
+        const ipc_stage_t *s = &stages[i];
+        const ipc_port_t *other;
+        for (uint8_t k = 0; k < s->n_in; ++k) {
+            if (find_port(g, s->in[k].pipe, true, n, 0, &other) < n) continue;
+            ipc_pipe_t *p = port_pipe(&s->in[k]);
+            CC_ATOMIC_RESTORE() {
+                p->wake_cb = graph_wake;
+                p->wake_ctx = runner;
+            }
+        }
+        for (uint8_t k = 0; k < s->n_out; ++k) {
+            if (find_port(g, s->out[k].pipe, false, n, 0, &other) < n) continue;
+            ipc_pipe_set_space(port_pipe(&s->out[k]), graph_wake, runner, port_need(&s->out[k]));
+        }
+    }
+    return ERR_SUCCESS;
+}
+
+uint16_t ipc_graph_run(ipc_graph_t *g)
+{
+    if (!g) return 0;
+    uint16_t total = 0;
+    uint16_t work = 0;
+
+    for (uint8_t pass = 0; pass < IPC_GRAPH_PASSES; ++pass) {
+        work = 0;
+        for (uint8_t i = 0; i < g->n; ++i) {
+            ipc_stage_t *s = &g->stages[i];
+            uint8_t limit = s->batch ? s->batch : UINT8_MAX;
+            uint8_t calls = 0;
+            while (calls < limit && stage_ready(s)) {
+                int ret = s->run(s);
+                if (ret == ERR_SUCCESS) {
+                    calls++;
+                    continue;
+                }
+                if (ret != ERR_IO_BUSY) s->errors++;
+                break;
+            }
+            s->calls += calls;
+            work += calls;
+        }
+        total += work;
+        if (work == 0) break;
+    }
+
+    /* still busy after the last pass: come back after the other processes */
+    if (work > 0 && g->runner) process_poll(g->runner);
+    return total;
+}
+
+#endif /* IPC_CONF_PIPE_SPACE */
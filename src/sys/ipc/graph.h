@@ -0,0 +1,130 @@
+// file: ./src/sys/ipc/graph.h
+#ifndef __IPC_GRAPH_H__
+#define __IPC_GRAPH_H__ 1
+
+/* Dataflow graphs: pipelines of stages connected by pipes.
+ *
+ * A stage is a function with typed input and output ports. A port is an
+ * ipc_pipe carrying items of a fixed size (IPC_PORT_PIPE) or an ipc_fpipe
+ * carrying records (IPC_PORT_FPIPE). A pipe that one stage writes and
+ * another reads is an edge of the graph; a pipe with only a reader in the
+ * graph is an input (fed by an ISR or another process), one with only a
+ * writer is an output.
+ *
+ * One process runs the whole graph with ipc_graph_run(). A stage is called
+ * only when it is ready: every input holds an item (a record) and every
+ * output has room for an item (the largest record). While it stays ready it
+ * is called again, up to its batch limit, so one activation drains as much
+ * as the pipes allow. Stages run in the order of the stage array, which
+ * must list upstream stages before downstream ones; a pass over the array
+ * therefore moves data from the inputs to the outputs, and passes repeat
+ * while any stage did work.
+ *
+ * ipc_graph_init() checks the topology once: every pipe has at most one
+ * writer and one reader stage, both see it as the same kind with the same
+ * item size, items fit the pipes, and no stage reads a pipe written by a
+ * later stage (which also rules out cycles). It then installs the wake
+ * callbacks: inputs poll the runner process when data arrives, outputs
+ * when space is freed. No wiring code is needed inside the graph.
+ *
+ *   static int filter(ipc_stage_t *s);  // reads one sample, writes one
+ *
+ *   static const ipc_port_t filter_in[]  = { IPC_PORT_PIPE(&raw, 2) };
+ *   static const ipc_port_t filter_out[] = { IPC_PORT_PIPE(&smooth, 2) };
+ *   static ipc_stage_t stages[] = {
+ *       IPC_STAGE(filter, NULL, filter_in, filter_out, 16),
+ *       ...
+ *   };
+ */
+
+#include "../ipc.h"
+#include "../process.h"
+#include "fpipe.h"
+
+#if !IPC_CONF_PIPE_SPACE
+#error "sys/ipc/graph.h needs IPC_CONF_PIPE_SPACE"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Port kinds */
+#define IPC_PORT_BYTES    0   /* ipc_pipe_t of items of `unit` bytes */
+#define IPC_PORT_FRAMES   1   /* ipc_fpipe_t of records of up to `unit` bytes */
+
+/* Passes over the stages per ipc_graph_run(); when the last one still did
+ * work, the runner polls itself to let other processes in first.
+ */
+#define IPC_GRAPH_PASSES  4
+
+typedef struct ipc_port {
+    void *pipe;               /* ipc_pipe_t or ipc_fpipe_t */
+    uint8_t kind;             /* IPC_PORT_BYTES or IPC_PORT_FRAMES */
+    uint16_t unit;            /* item size, or largest record (frames; 0 on inputs) */
+} ipc_port_t;
+
+#define IPC_PORT_PIPE(pipe, unit)    { (pipe), IPC_PORT_BYTES, (unit) }
+#define IPC_PORT_FPIPE(fpipe, unit)  { (fpipe), IPC_PORT_FRAMES, (unit) }
+
+typedef struct ipc_stage ipc_stage_t;
+
+/* Do one unit of work: consume one item or record from the inputs and
+ * produce on the outputs. Return ERR_SUCCESS after doing work, ERR_IO_BUSY
+ * when no progress is possible now (e.g. a record did not fit), or another
+ * ERR_* code, which is counted in errors. Anything but ERR_SUCCESS ends the
+ * batch of the stage for this pass.
+ */
+typedef int (*ipc_stage_fn_t)(ipc_stage_t *s);
+
+struct ipc_stage {
+    ipc_stage_fn_t run;       /* stage function */
+    void *ctx;                /* user data */
+    const ipc_port_t *in;     /* input ports */
+    const ipc_port_t *out;    /* output ports */
+    uint8_t n_in;             /* number of inputs (0: a source, always has input) */
+    uint8_t n_out;            /* number of outputs (0: a sink) */
+    uint8_t batch;            /* calls per pass at most, 0 = 255 */
+    uint16_t errors;          /* calls that returned an error */
+    uint32_t calls;           /* calls that did work */
+};
+
+#define IPC_STAGE(fn, ctx, in, out, batch) \
+    { (fn), (ctx), (in), (out), sizeof(in) / sizeof(ipc_port_t), sizeof(out) / sizeof(ipc_port_t), (batch), 0, 0 }
+#define IPC_STAGE_SOURCE(fn, ctx, out, batch) \
+    { (fn), (ctx), NULL, (out), 0, sizeof(out) / sizeof(ipc_port_t), (batch), 0, 0 }
+#define IPC_STAGE_SINK(fn, ctx, in, batch) \
+    { (fn), (ctx), (in), NULL, sizeof(in) / sizeof(ipc_port_t), 0, (batch), 0, 0 }
+
+/* Pipes of the ports of a stage */
+#define IPC_STAGE_IN(s, i)         ((ipc_pipe_t*)(s)->in[i].pipe)
+#define IPC_STAGE_OUT(s, i)        ((ipc_pipe_t*)(s)->out[i].pipe)
+#define IPC_STAGE_FIN(s, i)        ((ipc_fpipe_t*)(s)->in[i].pipe)
+#define IPC_STAGE_FOUT(s, i)       ((ipc_fpipe_t*)(s)->out[i].pipe)
+
+typedef struct ipc_graph {
+    ipc_stage_t *stages;      /* stages, upstream first */
+    uint8_t n;                /* number of stages */
+    struct process *runner;   /* process that calls ipc_graph_run() */
+} ipc_graph_t;
+
+/* Validate the topology and install the wake callbacks of the inputs and
+ * the space callbacks of the outputs (both poll runner).
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL for a missing stage function or
+ * pipe, ERR_HANDLE_TYPE when the ends of a pipe disagree on kind or item
+ * size, ERR_ACCESS_OWNER for a pipe with two writers or two readers,
+ * ERR_INIT_DEPENDENCY when a stage reads a pipe written by a later stage,
+ * or ERR_MSG_SIZE when an item can never fit its pipe.
+ */
+int ipc_graph_init(ipc_graph_t *g, ipc_stage_t *stages, uint8_t n, struct process *runner);
+
+/* Run ready stages, up to IPC_GRAPH_PASSES passes. Call from the runner
+ * process on every event. Returns the number of calls that did work.
+ */
+uint16_t ipc_graph_run(ipc_graph_t *g);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IPC_GRAPH_H__ */
@@ -0,0 +1,108 @@
+// file: ./src/sys/ipc/latency.c
+
+#include "latency.h"
+#include <string.h>
+
+#if IPC_CONF_TIMESTAMP
+
+/* -------------------------------------------------------------------------
+ * Path table. Entries are taken in order and never given back before
+ * ipc_latency_reset(), so lat_used only grows and a lookup scans
+ * lat_paths[0 .. lat_used - 1]. Every update is one atomic section.
+ * ----------------------------------------------------------------------*/
+
+static ipc_latency_hist_t lat_paths[IPC_CONF_LATENCY_PATHS];
+static uint8_t lat_used = 0;
+static uint16_t lat_lost = 0;
+
+/* Bucket of a sample: the number of bits above IPC_CONF_LATENCY_SHIFT */
+static uint8_t lat_bucket(uint32_t ticks)
+{
+    uint8_t b = 0;
+    ticks >>= IPC_CONF_LATENCY_SHIFT;
+    while (ticks != 0 && b < IPC_CONF_LATENCY_BUCKETS - 1) {
+        ticks >>= 1;
+        b++;
+    }
+    return b;
+}
+
+/* Index of the path src -> dst, or lat_used (caller must ensure atomic) */
+static uint8_t lat_find_nolock(const void *src, const void *dst)
+{
+    uint8_t i;
+    for (i = 0; i < lat_used; ++i) {
+        if (lat_paths[i].src == src && lat_paths[i].dst == dst) break;
+    }
+    return i;
+}
+
+void ipc_latency_record(const void *src, const void *dst, uint32_t ticks)
+{
+    uint8_t b = lat_bucket(ticks);
+    CC_ATOMIC_RESTORE() {
+        uint8_t i = lat_find_nolock(src, dst);
+        if (i == lat_used && lat_used < IPC_CONF_LATENCY_PATHS) {
+            memset(&lat_paths[i], 0, sizeof(lat_paths[i]));
+            lat_paths[i].src = src;
+            lat_paths[i].dst = dst;
+            lat_used++;
+        }
+        if (i < lat_used) {
+            ipc_latency_hist_t *h = &lat_paths[i];
+            h->count++;
+            h->total += ticks;
+            if (ticks > h->max) h->max = ticks;
+            if (h->bucket[b] != UINT16_MAX) h->bucket[b]++;
+        }
+        else if (lat_lost != UINT16_MAX) {
+            lat_lost++;
+        }
+    }
+}
+
+int ipc_latency_get(uint8_t i, ipc_latency_hist_t *out)
+{
+    if (!out) return ERR_HANDLE_NULL;
+    int ret = ERR_VAL_RANGE;
+    CC_ATOMIC_RESTORE() {
+        if (i < lat_used) {
+            *out = lat_paths[i];
+            ret = ERR_SUCCESS;
+        }
+    }
+    return ret;
+}
+
+int ipc_latency_find(const void *src, const void *dst, ipc_latency_hist_t *out)
+{
+    if (!out) return ERR_HANDLE_NULL;
+    int ret = ERR_VAL_RANGE;
+    CC_ATOMIC_RESTORE() {
+        uint8_t i = lat_find_nolock(src, dst);
+        if (i < lat_used) {
+            *out = lat_paths[i];
+            ret = ERR_SUCCESS;
+        }
+    }
+    return ret;
+}
+
+uint16_t ipc_latency_lost(void)
+{
+    uint16_t n;
+    CC_ATOMIC_RESTORE() {
+        n = lat_lost;
+    }
+    return n;
+}
+
+void ipc_latency_reset(void)
+{
+    CC_ATOMIC_RESTORE() {
+        lat_used = 0;
+        lat_lost = 0;
+    }
+}
+
+#endif /* IPC_CONF_TIMESTAMP */
@@ -0,0 +1,73 @@
+// file: ./src/sys/ipc/latency.h
+#ifndef __IPC_LATENCY_H__
+#define __IPC_LATENCY_H__ 1
+
+/* Latency histograms per path (needs IPC_CONF_TIMESTAMP).
+ *
+ * A path is a pair of addresses, a source and a destination: usually two
+ * processes, but a pipe or a message pool works as well. The scheduler
+ * records one sample per delivered event on the path from the posting
+ * process to the receiver (source NULL for process_post_from_isr() and for
+ * posts from outside processes):
+ *
+ *   - for PROCESS_EVENT_MSG the age of the message (ipc_msg_age()), i.e.
+ *     the time from its allocation to the delivery, end to end;
+ *   - for all other events the time the event spent in the queue.
+ *
+ * Code can add its own samples, e.g. the age of a pipe when its reader runs:
+ *
+ *   ipc_latency_record(&uart_rx, PROCESS_CURRENT(), ipc_pipe_age(&uart_rx));
+ *
+ * The first IPC_CONF_LATENCY_PATHS paths get a histogram; samples of further
+ * paths are counted by ipc_latency_lost(). Bucket i counts samples below
+ * 2^(IPC_CONF_LATENCY_SHIFT + i) clock ticks, the last bucket all others.
+ */
+
+#include "../ipc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if IPC_CONF_TIMESTAMP
+
+#if IPC_CONF_LATENCY_BUCKETS < 1 || IPC_CONF_LATENCY_SHIFT + IPC_CONF_LATENCY_BUCKETS > 32
+#error "IPC_CONF_LATENCY_BUCKETS must be 1.. and the buckets must fit 32 bits"
+#endif
+
+/* Histogram of one path */
+typedef struct ipc_latency_hist {
+    const void *src;                              /* source (NULL: ISR / outside processes) */
+    const void *dst;                              /* destination */
+    uint32_t count;                               /* samples */
+    uint32_t max;                                 /* largest sample */
+    uint32_t total;                               /* sum of the samples (wraps) */
+    uint16_t bucket[IPC_CONF_LATENCY_BUCKETS];    /* samples per bucket, saturating */
+} ipc_latency_hist_t;
+
+/* Add a sample of ticks to the path src -> dst. Safe to call from ISR. */
+void ipc_latency_record(const void *src, const void *dst, uint32_t ticks);
+
+/* Copy the histogram of the i-th path (in order of the first sample).
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL or ERR_VAL_RANGE past the last path.
+ */
+int ipc_latency_get(uint8_t i, ipc_latency_hist_t *out);
+
+/* Copy the histogram of the path src -> dst.
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL or ERR_VAL_RANGE for an unknown path.
+ */
+int ipc_latency_find(const void *src, const void *dst, ipc_latency_hist_t *out);
+
+/* Samples dropped because all IPC_CONF_LATENCY_PATHS histograms are in use */
+uint16_t ipc_latency_lost(void);
+
+/* Forget all paths and samples */
+void ipc_latency_reset(void);
+
+#endif /* IPC_CONF_TIMESTAMP */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IPC_LATENCY_H__ */
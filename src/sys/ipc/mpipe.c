@@ -0,0 +1,268 @@
+// file: ./src/sys/ipc/mpipe.c
+
+#include "mpipe.h"
+#include <string.h>
+
+/* -------------------------------------------------------------------------
+ * Multicast pipe implementation. The buffer keeps one slot empty, as in
+ * ipc_pipe, so a reader with tail == head is empty. All index updates are
+ * wrapped in CC_ATOMIC_RESTORE(); wake and space callbacks are called after
+ * the atomic block.
+ * ----------------------------------------------------------------------*/
+
+static size_t reader_avail(const ipc_mpipe_t *m, const ipc_mpipe_reader_t *r)
+{
+    size_t h = m->head;
+    size_t t = r->tail;
+    return (h >= t) ? (h - t) : (m->size + h - t);
+}
+
+/* Free space as seen by the slowest attached reader */
+static size_t space_nolock(const ipc_mpipe_t *m)
+{
+    size_t used = 0;
+    for (uint8_t i = 0; i < m->n_readers; ++i) {
+        const ipc_mpipe_reader_t *r = &m->readers[i];
+        if (!r->active) continue;
+        size_t avail = reader_avail(m, r);
+        if (avail > used) used = avail;
+    }
+    return m->size - 1 - used;
+}
+
+static bool reader_valid(const ipc_mpipe_t *m, uint8_t id)
+{
+    return m && id < m->n_readers && m->readers[id].active;
+}
+
+static void notify_space(ipc_mpipe_t *m, size_t before, size_t after)
+{
+#if IPC_CONF_PIPE_SPACE
+    if (m->space_cb && before < m->space_low && after >= m->space_low) {
+        m->space_cb(m->space_ctx);
+    }
+#else
+    (void)m; (void)before; (void)after;
+#endif
+}
+
+int ipc_mpipe_init(ipc_mpipe_t *m, void *buffer, size_t size,
+                   ipc_mpipe_reader_t *readers, uint8_t n_readers, uint8_t policy)
+{
+    if (!m || !buffer || !readers || size < 2 || n_readers == 0) return ERR_PROC_INVAL;
+    if (n_readers > IPC_MPIPE_MAX_READERS || policy > IPC_MPIPE_DROP_SLOW) return ERR_VAL_RANGE;
+    m->buf = (uint8_t*)buffer;
+    m->size = size;
+    m->head = 0;
+    m->readers = readers;
+    m->n_readers = n_readers;
+    m->policy = policy;
+#if IPC_CONF_PIPE_SPACE
+    m->space_cb = NULL;
+    m->space_ctx = NULL;
+    m->space_low = 0;
+#endif
+    memset(readers, 0, sizeof(ipc_mpipe_reader_t) * n_readers);
+    return ERR_SUCCESS;
+}
+
+int ipc_mpipe_attach(ipc_mpipe_t *m, uint8_t *id, ipc_wake_cb_t wake_cb, void *wake_ctx)
+{
+    if (!m || !id) return ERR_HANDLE_NULL;
+    int ret = ERR_BOUNDS_UPPER;
+    CC_ATOMIC_RESTORE() {
+        for (uint8_t i = 0; i < m->n_readers; ++i) {
+            ipc_mpipe_reader_t *r = &m->readers[i];
+            if (r->active) continue;
+            r->tail = m->head;
+            r->dropped = 0;
+            r->peek_tail = m->head;
+            r->peek_dropped = 0;
+            r->wake_cb = wake_cb;
+            r->wake_ctx = wake_ctx;
+            r->active = true;
+            *id = i;
+            ret = ERR_SUCCESS;
+            break;
+        }
+    }
+    return ret;
+}
+
+void ipc_mpipe_detach(ipc_mpipe_t *m, uint8_t id)
+{
+    size_t before = 0, after = 0;
+    if (!reader_valid(m, id)) return;
+    CC_ATOMIC_RESTORE() {
+        before = space_nolock(m);
+        m->readers[id].active = false;
+        after = space_nolock(m);
+    }
+    notify_space(m, before, after);
+}
+
+size_t ipc_mpipe_available(const ipc_mpipe_t *m, uint8_t id)
+{
+    if (!reader_valid(m, id)) return 0;
+    size_t avail;
+    CC_ATOMIC_RESTORE() {
+        avail = reader_avail(m, &m->readers[id]);
+    }
+    return avail;
+}
+
+size_t ipc_mpipe_space(const ipc_mpipe_t *m)
+{
+    if (!m) return 0;
+    size_t space;
+    CC_ATOMIC_RESTORE() {
+        space = space_nolock(m);
+    }
+    return space;
+}
+
+size_t ipc_mpipe_write(ipc_mpipe_t *m, const uint8_t *src, size_t len)
+{
+    if (!m || !src || len == 0) return 0;
+    size_t towrite = 0;
+    uint16_t wake = 0;      /* readers that go from empty to non-empty */
+
+    CC_ATOMIC_RESTORE() {
+        const size_t max = m->size - 1;
+        if (m->policy == IPC_MPIPE_DROP_SLOW) {
+            towrite = (len <= max) ? len : max;
+        }
+        else {
+            size_t space = space_nolock(m);
+            towrite = (len <= space) ? len : space;
+        }
+
+        if (towrite > 0) {
+            for (uint8_t i = 0; i < m->n_readers; ++i) {
+                ipc_mpipe_reader_t *r = &m->readers[i];
+                if (!r->active) continue;
+                size_t avail = reader_avail(m, r);
+                if (avail + towrite > max) {
+                    /* only with IPC_MPIPE_DROP_SLOW: resync to the new data */
+                    r->dropped += avail;
+                    r->tail = m->head;
+                    avail = 0;
+                }
+                if (avail == 0) wake |= (uint16_t)(1u << i);
+            }
+
+            size_t h = m->head;
+            size_t first = m->size - h;
+            if (first > towrite) first = towrite;
+            memcpy(&m->buf[h], src, first);
+            memcpy(&m->buf[0], src + first, towrite - first);
+            m->head = (h + towrite) % m->size;
+        }
+    } /* atomic end */
+
+    for (uint8_t i = 0; wake != 0; ++i, wake >>= 1) {
+        ipc_mpipe_reader_t *r = &m->readers[i];
+        if ((wake & 1) && r->wake_cb) {
+            r->wake_cb(r->wake_ctx);
+        }
+    }
+    return towrite;
+}
+
+size_t ipc_mpipe_read(ipc_mpipe_t *m, uint8_t id, uint8_t *dst, size_t len)
+{
+    if (!reader_valid(m, id) || !dst || len == 0) return 0;
+    ipc_mpipe_reader_t *r = &m->readers[id];
+    size_t toread = 0;
+    size_t before = 0, after = 0;
+
+    CC_ATOMIC_RESTORE() {
+        size_t avail = reader_avail(m, r);
+        toread = (len <= avail) ? len : avail;
+        if (toread > 0) {
+            before = space_nolock(m);
+            size_t t = r->tail;
+            size_t first = m->size - t;
+            if (first > toread) first = toread;
+            memcpy(dst, &m->buf[t], first);
+            memcpy(dst + first, &m->buf[0], toread - first);
+            r->tail = (t + toread) % m->size;
+            after = space_nolock(m);
+        }
+    } /* atomic end */
+
+    if (toread > 0) {
+        notify_space(m, before, after);
+    }
+    return toread;
+}
+
+int ipc_mpipe_read_peek(ipc_mpipe_t *m, uint8_t id, const uint8_t **ptr, size_t *len)
+{
+    if (!ptr || !len) return ERR_HANDLE_NULL;
+    if (!reader_valid(m, id)) return ERR_PROC_INVAL;
+    ipc_mpipe_reader_t *r = &m->readers[id];
+    CC_ATOMIC_RESTORE() {
+        size_t h = m->head;
+        size_t t = r->tail;
+        *len = (h >= t) ? (h - t) : (m->size - t);
+        *ptr = &m->buf[t];
+        r->peek_tail = t;
+        r->peek_dropped = r->dropped;
+    }
+    return ERR_SUCCESS;
+}
+
+int ipc_mpipe_read_consume(ipc_mpipe_t *m, uint8_t id, size_t n)
+{
+    if (!reader_valid(m, id)) return ERR_PROC_INVAL;
+    if (n == 0) return ERR_SUCCESS;
+    ipc_mpipe_reader_t *r = &m->readers[id];
+    int ret = ERR_SUCCESS;
+    size_t before = 0, after = 0;
+
+    CC_ATOMIC_RESTORE() {
+        if (m->policy == IPC_MPIPE_DROP_SLOW
+            && (r->tail != r->peek_tail || r->dropped != r->peek_dropped)) {
+            /* the writer resynchronized us: the peeked span is gone */
+            ret = ERR_HANDLE_SHADOW;
+        }
+        else if (n > reader_avail(m, r)) {
+            ret = ERR_VAL_RANGE;
+        }
+        else {
+            before = space_nolock(m);
+            r->tail = (r->tail + n) % m->size;
+            r->peek_tail = r->tail;
+            after = space_nolock(m);
+        }
+    }
+    if (ret != ERR_SUCCESS) return ret;
+
+    notify_space(m, before, after);
+    return ERR_SUCCESS;
+}
+
+size_t ipc_mpipe_dropped(const ipc_mpipe_t *m, uint8_t id)
+{
+    if (!reader_valid(m, id)) return 0;
+    size_t dropped;
+    CC_ATOMIC_RESTORE() {
+        dropped = m->readers[id].dropped;
+    }
+    return dropped;
+}
+
+#if IPC_CONF_PIPE_SPACE
+void ipc_mpipe_set_space(ipc_mpipe_t *m, ipc_wake_cb_t cb, void *ctx, size_t low_watermark)
+{
+    if (!m) return;
+    if (low_watermark == 0) low_watermark = 1;
+    if (low_watermark > m->size - 1) low_watermark = m->size - 1;
+    CC_ATOMIC_RESTORE() {
+        m->space_cb = cb;
+        m->space_ctx = ctx;
+        m->space_low = low_watermark;
+    }
+}
+#endif
@@ -0,0 +1,114 @@
+// file: ./src/sys/ipc/mpipe.h
+#ifndef __IPC_MPIPE_H__
+#define __IPC_MPIPE_H__ 1
+
+/* Multicast pipe: one writer, many independent readers.
+ *
+ * An ipc_mpipe is a byte ring buffer like ipc_pipe, with one head and one
+ * tail (cursor) per registered reader. The writer copies each byte once,
+ * whatever the number of readers, and every reader consumes the stream at its
+ * own pace. Each reader has its own wake callback, invoked when its view of
+ * the pipe goes from empty to non-empty.
+ *
+ * The free space is limited by the slowest reader. With IPC_MPIPE_BLOCK the
+ * writer gets short writes until the slowest reader catches up. With
+ * IPC_MPIPE_DROP_SLOW the writer never blocks: a reader that would be
+ * overrun loses its pending bytes and is resynchronized to the new data. The
+ * number of bytes it lost is reported by ipc_mpipe_dropped().
+ *
+ * All index updates are done inside CC_ATOMIC_RESTORE(); callbacks are called
+ * outside the atomic block, as in ipc.c.
+ */
+
+#include "../ipc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum number of readers of one multicast pipe */
+#define IPC_MPIPE_MAX_READERS 16
+
+/* Writer policies */
+#define IPC_MPIPE_BLOCK       0   /* writes are limited by the slowest reader */
+#define IPC_MPIPE_DROP_SLOW   1   /* readers that fall behind lose their pending bytes */
+
+typedef struct ipc_mpipe_reader {
+    size_t tail;              /* read index of this reader */
+    size_t dropped;           /* bytes lost by this reader (IPC_MPIPE_DROP_SLOW) */
+    size_t peek_tail;         /* tail when the span was peeked (IPC_MPIPE_DROP_SLOW) */
+    size_t peek_dropped;      /* dropped when the span was peeked (IPC_MPIPE_DROP_SLOW) */
+    ipc_wake_cb_t wake_cb;    /* callback to notify this reader (may be NULL) */
+    void *wake_ctx;           /* context passed to wake_cb */
+    bool active;              /* slot is attached */
+} ipc_mpipe_reader_t;
+
+typedef struct ipc_mpipe {
+    uint8_t *buf;             /* pointer to buffer storage */
+    size_t size;              /* total buffer size in bytes (must be >= 2) */
+    size_t head;              /* write index (next write position) */
+    ipc_mpipe_reader_t *readers; /* reader slots */
+    uint8_t n_readers;        /* number of reader slots */
+    uint8_t policy;           /* IPC_MPIPE_BLOCK or IPC_MPIPE_DROP_SLOW */
+#if IPC_CONF_PIPE_SPACE
+    ipc_wake_cb_t space_cb;   /* callback to notify writer (may be NULL) */
+    void *space_ctx;          /* context passed to space_cb */
+    size_t space_low;         /* low watermark: space_cb fires when free space rises to it */
+#endif
+} ipc_mpipe_t;
+
+/* Initialize a multicast pipe. buffer must be `size` bytes, readers must hold
+ * n_readers slots (at most IPC_MPIPE_MAX_READERS).
+ * Returns ERR_SUCCESS, ERR_PROC_INVAL on bad args or ERR_VAL_RANGE.
+ */
+int ipc_mpipe_init(ipc_mpipe_t *m, void *buffer, size_t size,
+                   ipc_mpipe_reader_t *readers, uint8_t n_readers, uint8_t policy);
+
+/* Attach a reader. It sees the bytes written from now on. On success its
+ * slot number is stored in *id.
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL or ERR_BOUNDS_UPPER when all slots are used.
+ */
+int ipc_mpipe_attach(ipc_mpipe_t *m, uint8_t *id, ipc_wake_cb_t wake_cb, void *wake_ctx);
+
+/* Detach a reader; its pending bytes no longer hold back the writer. */
+void ipc_mpipe_detach(ipc_mpipe_t *m, uint8_t id);
+
+/* Bytes available to reader id */
+size_t ipc_mpipe_available(const ipc_mpipe_t *m, uint8_t id);
+
+/* Free space for the writer (limited by the slowest reader) */
+size_t ipc_mpipe_space(const ipc_mpipe_t *m);
+
+/* Write up to len bytes into the pipe, once for all readers. Returns the number
+ * of bytes written. Readers that were empty are woken after the write.
+ */
+size_t ipc_mpipe_write(ipc_mpipe_t *m, const uint8_t *src, size_t len);
+
+/* Read up to len bytes for reader id. Returns the number of bytes read. */
+size_t ipc_mpipe_read(ipc_mpipe_t *m, uint8_t id, uint8_t *dst, size_t len);
+
+/* Zero-copy read for reader id, like ipc_pipe_read_peek()/ipc_pipe_read_consume().
+ * With IPC_MPIPE_DROP_SLOW the writer may resynchronize the reader between
+ * the two calls and overwrite the peeked span. The consume then fails with
+ * ERR_HANDLE_SHADOW and leaves the tail alone; the span must be discarded
+ * and peeked again. Several consumes may follow one peek.
+ */
+int ipc_mpipe_read_peek(ipc_mpipe_t *m, uint8_t id, const uint8_t **ptr, size_t *len);
+int ipc_mpipe_read_consume(ipc_mpipe_t *m, uint8_t id, size_t n);
+
+/* Total number of bytes reader id lost because it fell behind */
+size_t ipc_mpipe_dropped(const ipc_mpipe_t *m, uint8_t id);
+
+#if IPC_CONF_PIPE_SPACE
+/* Writer-side backpressure callback, see ipc_pipe_set_space(). It fires when a
+ * read or consume lifts ipc_mpipe_space() from below low_watermark to
+ * low_watermark or more.
+ */
+void ipc_mpipe_set_space(ipc_mpipe_t *m, ipc_wake_cb_t cb, void *ctx, size_t low_watermark);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IPC_MPIPE_H__ */
@@ -0,0 +1,166 @@
+// file: ./src/sys/ipc/rpc.c
+
+#include "rpc.h"
+
+#if IPC_CONF_RPC
+
+/* -------------------------------------------------------------------------
+ * Pending call table. A correlation id is (generation << 8) | (index + 1),
+ * so it is never 0 and its low byte selects the table entry. An entry is
+ * free when its id is 0. All table updates are wrapped in
+ * CC_ATOMIC_RESTORE(), because ipc_reply() may run in an ISR.
+ * ----------------------------------------------------------------------*/
+
+#define RPC_INDEX(id)   ((uint8_t)(((id) & 0xFF) - 1))
+
+static struct {
+    uint16_t id;                  /* correlation id of the call, 0 = free */
+    uint8_t gen;                  /* generation of the next call in this entry */
+    ipc_reply_slot_t *slot;       /* where the result goes */
+    struct process *caller;       /* polled on reply */
+} rpc_pending[IPC_CONF_RPC_PENDING];
+
+static uint8_t rpc_deadlines;     /* pending calls with an armed deadline */
+
+/* Release the entry of the call on slot and set its final status (caller must ensure atomic) */
+static void rpc_finish_nolock(ipc_reply_slot_t *slot, uint8_t status, int result)
+{
+    if (slot->status != IPC_REPLY_PENDING) return;
+    if (slot->deadline.interval != 0) {
+        slot->deadline.interval = 0;
+        --rpc_deadlines;
+    }
+    uint8_t i = RPC_INDEX(slot->id);
+    if (i < IPC_CONF_RPC_PENDING && rpc_pending[i].id == slot->id) {
+        rpc_pending[i].id = 0;
+    }
+    slot->result = result;
+    slot->status = status;
+}
+
+int ipc_call(struct process *dest, ipc_msg_t *msg, ipc_reply_slot_t *slot)
+{
+    if (!dest || !msg || !slot) return ERR_HANDLE_NULL;
+    int ret = ERR_BOUNDS_UPPER;
+
+    CC_ATOMIC_RESTORE() {
+        if (slot->status == IPC_REPLY_PENDING) {
+            ret = ERR_IO_BUSY;
+        }
+        else {
+            for (uint8_t i = 0; i < IPC_CONF_RPC_PENDING; ++i) {
+                if (rpc_pending[i].id != 0) continue;
+                uint16_t id = (uint16_t)(((uint16_t)rpc_pending[i].gen++ << 8) | (i + 1));
+                rpc_pending[i].id = id;
+                rpc_pending[i].slot = slot;
+                rpc_pending[i].caller = process_current;
+                slot->id = id;
+                slot->status = IPC_REPLY_PENDING;
+                slot->result = 0;
+                slot->deadline.interval = 0;
+                msg->call_id = id;
+                ret = ERR_SUCCESS;
+                break;
+            }
+        }
+    }
+    if (ret != ERR_SUCCESS) return ret;
+
+    if (!process_post(dest, PROCESS_EVENT_MSG, msg)) {
+        CC_ATOMIC_RESTORE() {
+            rpc_finish_nolock(slot, IPC_REPLY_IDLE, 0);
+        }
+        msg->call_id = 0;
+        return ERR_PIPE_FULL;
+    }
+    return ERR_SUCCESS;
+}
+
+int ipc_reply(ipc_msg_t *msg, int result)
+{
+    if (!msg) return ERR_HANDLE_NULL;
+    uint16_t id = msg->call_id;
+    uint8_t i = RPC_INDEX(id);
+    if (id == 0 || i >= IPC_CONF_RPC_PENDING) return ERR_PROC_INVAL;
+    msg->call_id = 0;
+
+    int ret = ERR_PROC_CANCELLED;
+    struct process *caller = NULL;
+    CC_ATOMIC_RESTORE() {
+        if (rpc_pending[i].id == id) {
+            caller = rpc_pending[i].caller;
+            rpc_finish_nolock(rpc_pending[i].slot, IPC_REPLY_DONE, result);
+            ret = ERR_SUCCESS;
+        }
+    }
+    if (caller) process_poll(caller);
+    return ret;
+}
+
+void ipc_call_cancel(ipc_reply_slot_t *slot)
+{
+    if (!slot) return;
+    CC_ATOMIC_RESTORE() {
+        rpc_finish_nolock(slot, IPC_REPLY_IDLE, ERR_PROC_CANCELLED);
+    }
+}
+
+void ipc_rpc_drop_caller(struct process *p)
+{
+    if (!p) return;
+    CC_ATOMIC_RESTORE() {
+        for (uint8_t i = 0; i < IPC_CONF_RPC_PENDING; ++i) {
+            if (rpc_pending[i].id != 0 && rpc_pending[i].caller == p) {
+                rpc_finish_nolock(rpc_pending[i].slot, IPC_REPLY_IDLE, ERR_PROC_CANCELLED);
+            }
+        }
+    }
+}
+
+void ipc_reply_arm(ipc_reply_slot_t *slot, uint16_t timeout)
+{
+    if (!slot) return;
+    CC_ATOMIC_RESTORE() {
+        /* a reply that came first leaves nothing to arm */
+        if (slot->status == IPC_REPLY_PENDING) {
+            if (slot->deadline.interval != 0) --rpc_deadlines;
+            slot->deadline.interval = 0;
+            if (timeout != 0) {
+                timer_set(&slot->deadline, clock_from_millis(timeout));
+                if (slot->deadline.interval == 0) slot->deadline.interval = 1;
+                ++rpc_deadlines;
+            }
+        }
+    }
+}
+
+bool ipc_reply_ready(ipc_reply_slot_t *slot)
+{
+    if (!slot || slot->status != IPC_REPLY_PENDING) return true;
+    /* woken for another reason: the deadline may have passed already */
+    if (slot->deadline.interval == 0 || !timer_expired(&slot->deadline)) return false;
+    CC_ATOMIC_RESTORE() {
+        rpc_finish_nolock(slot, IPC_REPLY_TIMEOUT, ERR_CLK_EXPIRED);
+    }
+    /* a reply may have won the race */
+    return true;
+}
+
+void ipc_rpc_expire(void)
+{
+    if (rpc_deadlines == 0) return;
+    for (uint8_t i = 0; i < IPC_CONF_RPC_PENDING; ++i) {
+        struct process *caller = NULL;
+        CC_ATOMIC_RESTORE() {
+            ipc_reply_slot_t *slot = rpc_pending[i].slot;
+            if (rpc_pending[i].id != 0 && slot->deadline.interval != 0
+                && timer_expired(&slot->deadline)) {
+                caller = rpc_pending[i].caller;
+                rpc_finish_nolock(slot, IPC_REPLY_TIMEOUT, ERR_CLK_EXPIRED);
+            }
+        }
+        if (caller) process_poll(caller);
+    }
+}
+
+#endif /* IPC_CONF_RPC */
@@ -0,0 +1,109 @@
+// file: ./src/sys/ipc/rpc.h
+#ifndef __IPC_RPC_H__
+#define __IPC_RPC_H__ 1
+
+/* Request/response calls over ipc_msg_t.
+ *
+ * ipc_call() posts a message to a server process as PROCESS_EVENT_MSG and
+ * stamps it with a correlation id. The server handles the message as usual
+ * and answers with ipc_reply(msg, result), which stores the result in the
+ * caller's reply slot and polls the caller. The caller parks in
+ * PT_AWAIT_REPLY() until the reply arrives or the deadline passes:
+ *
+ *   static ipc_reply_slot_t reply;
+ *   ...
+ *   if (ipc_call(&server, msg, &reply) == ERR_SUCCESS) {
+ *     PROCESS_AWAIT_REPLY(&reply, 100);
+ *     if (reply.status == IPC_REPLY_DONE) use(reply.result);
+ *   }
+ *
+ * Calls in flight live in a fixed table of IPC_CONF_RPC_PENDING entries.
+ * The correlation id holds the table index, so ipc_reply() finds its call
+ * without a search, and a generation count, so a late reply to a call that
+ * timed out does not match a newer call in the same entry.
+ *
+ * The message belongs to the server once ipc_call() succeeds, exactly like
+ * a message sent with process_post(); the server frees it after replying.
+ * Reply slots must outlive the call (static or part of a process frame).
+ */
+
+#include "../ipc.h"
+#include "../process.h"
+#if IPC_CONF_RPC
+#include "../timer.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if IPC_CONF_RPC
+
+#if IPC_CONF_RPC_PENDING > 255
+#error "IPC_CONF_RPC_PENDING must not exceed 255"
+#endif
+
+/* Reply slot status */
+#define IPC_REPLY_IDLE      0     /* no call made, or the call was cancelled */
+#define IPC_REPLY_PENDING   1     /* waiting for ipc_reply() */
+#define IPC_REPLY_DONE      2     /* result holds the value passed to ipc_reply() */
+#define IPC_REPLY_TIMEOUT   3     /* the deadline passed; result is ERR_CLK_EXPIRED */
+
+typedef struct ipc_reply_slot {
+    uint16_t id;                  /* correlation id of the last call */
+    volatile uint8_t status;      /* IPC_REPLY_* */
+    int result;                   /* reply value */
+    struct timer deadline;        /* armed by PT_AWAIT_REPLY(); interval 0 = none */
+} ipc_reply_slot_t;
+
+/* Post msg to dest and register a pending call that completes in slot.
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL, ERR_IO_BUSY when slot has a call in
+ * flight, ERR_BOUNDS_UPPER when the pending table is full, or ERR_PIPE_FULL
+ * when the event could not be posted (the caller keeps msg).
+ */
+int ipc_call(struct process *dest, ipc_msg_t *msg, ipc_reply_slot_t *slot);
+
+/* Answer the call carried by msg. Safe to call from ISR.
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL, ERR_PROC_INVAL when msg is not a
+ * call, or ERR_PROC_CANCELLED when the caller stopped waiting.
+ */
+int ipc_reply(ipc_msg_t *msg, int result);
+
+/* Stop waiting for the call in flight on slot (status becomes IPC_REPLY_IDLE) */
+void ipc_call_cancel(ipc_reply_slot_t *slot);
+
+/* Forget the calls made by process p; process_exit() calls this */
+void ipc_rpc_drop_caller(struct process *p);
+
+/* Arm the deadline of slot, timeout milliseconds from now (0 = wait forever) */
+void ipc_reply_arm(ipc_reply_slot_t *slot, uint16_t timeout);
+
+/* True once slot is no longer pending. Expires the call when its deadline
+ * passed. Does not poll: the caller is woken by ipc_reply(), or once by
+ * ipc_rpc_expire() when the deadline passes.
+ */
+bool ipc_reply_ready(ipc_reply_slot_t *slot);
+
+/* Expire the calls whose deadline passed and poll their callers; called by
+ * process_run() on every pass. Does nothing while no deadline is armed.
+ */
+void ipc_rpc_expire(void);
+
+/* Wait for the reply to the call on slot, at most timeout milliseconds
+ * (0 = no deadline). Check slot->status afterwards.
+ */
+#define PT_AWAIT_REPLY(pt, slot, timeout) \
+  do { \
+    ipc_reply_arm((slot), (timeout)); \
+    PT_WAIT_UNTIL(pt, ipc_reply_ready(slot)); \
+  } while(0)
+
+#define PROCESS_AWAIT_REPLY(slot, timeout) PT_AWAIT_REPLY(pt_process, slot, timeout)
+
+#endif /* IPC_CONF_RPC */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IPC_RPC_H__ */
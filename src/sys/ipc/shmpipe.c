@@ -0,0 +1,280 @@
+// file: ./src/sys/ipc/shmpipe.c
+
+#include "shmpipe.h"
+
+#if IPC_CONF_SHM_PIPE
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+/* -------------------------------------------------------------------------
+ * Region layout. Every group of fields that one side writes has a cache line
+ * of its own: head (writer), tail (reader), and the wakeup words of each
+ * side. magic is stored last by the creator, with release semantics, so a
+ * process that sees it also sees the rest of the header.
+ * ----------------------------------------------------------------------*/
+
+#define SHM_LINE        64
+#define SHM_MAGIC       0x50435049u     /* "IPCP" */
+
+struct ipc_shm_ring {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t size;                              /* ring bytes */
+    _Alignas(SHM_LINE) uint64_t head;           /* written by the writer */
+    _Alignas(SHM_LINE) uint64_t tail;           /* written by the reader */
+    _Alignas(SHM_LINE) uint32_t data_seq;       /* bumped to wake a waiting reader */
+    uint32_t reader_waiting;
+    _Alignas(SHM_LINE) uint32_t space_seq;      /* bumped to wake a waiting writer */
+    uint32_t writer_waiting;
+    _Alignas(SHM_LINE) uint8_t buf[];
+};
+
+static void shm_futex_wake(uint32_t *word)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+/* Sleep until *word != val, a wake, or ms milliseconds */
+static void shm_futex_wait(uint32_t *word, uint32_t val, uint32_t ms)
+{
+    struct timespec ts;
+#if defined(__linux__)
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    syscall(SYS_futex, word, FUTEX_WAIT, val, &ts, NULL, 0);
+#else
+    (void)word;
+    (void)val;
+    ts.tv_sec = 0;
+    ts.tv_nsec = (ms < 1 ? ms : 1) * 1000000L;
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static uint64_t shm_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/* Wake the other side if it sleeps; called after publishing an index */
+static void shm_notify(uint32_t *waiting, uint32_t *seq)
+{
+    /* orders the index store before the flag load, see ipc_shm_pipe_wait() */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiting, __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(seq, 1, __ATOMIC_SEQ_CST);
+        shm_futex_wake(seq);
+    }
+}
+
+static int shm_map(ipc_shm_pipe_t *sp, int fd, size_t len, const char *name, uint8_t role,
+                   ipc_wake_cb_t wake_cb, void *wake_ctx)
+{
+    void *m = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) return ERR_MAP_FAILED;
+    sp->ring = (struct ipc_shm_ring*)m;
+    sp->buf = sp->ring->buf;
+    sp->map_len = len;
+    sp->role = role;
+    sp->wake_cb = wake_cb;
+    sp->wake_ctx = wake_ctx;
+    strcpy(sp->name, name);
+    return ERR_SUCCESS;
+}
+
+static int shm_check_args(ipc_shm_pipe_t *sp, const char *name, uint8_t role)
+{
+    if (!sp || !name) return ERR_HANDLE_NULL;
+    if (role != IPC_SHM_WRITER && role != IPC_SHM_READER) return ERR_VAL_RANGE;
+    if (strlen(name) >= IPC_SHM_NAME_MAX) return ERR_BOUNDS_UPPER;
+    return ERR_SUCCESS;
+}
+
+int ipc_shm_pipe_create(ipc_shm_pipe_t *sp, const char *name, size_t size, uint8_t role,
+                        ipc_wake_cb_t wake_cb, void *wake_ctx)
+{
+    bool replace = (role & IPC_SHM_REPLACE) != 0;
+    role &= (uint8_t)~IPC_SHM_REPLACE;
+    int ret = shm_check_args(sp, name, role);
+    if (ret != ERR_SUCCESS) return ret;
+    if (size < 2 || (size & (size - 1)) != 0) return ERR_VAL_RANGE;
+
+    size_t len = sizeof(struct ipc_shm_ring) + size;
+    /* never take over a live region by accident, only a stale one on request */
+    if (replace) shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return errno == EEXIST ? ERR_FS_EXIST : ERR_MAP_FAILED;
+    if (ftruncate(fd, (off_t)len) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return ERR_MAP_FAILED;
+    }
+    ret = shm_map(sp, fd, len, name, role, wake_cb, wake_ctx);
+    if (ret != ERR_SUCCESS) {
+        shm_unlink(name);
+        return ret;
+    }
+    sp->size = size;
+    sp->mask = size - 1;
+    sp->owner = true;
+
+    /* the region is zero filled: indices, flags and sequence words start at 0 */
+    sp->ring->size = size;
+    __atomic_store_n(&sp->ring->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+    return ERR_SUCCESS;
+}
+
+int ipc_shm_pipe_open(ipc_shm_pipe_t *sp, const char *name, uint8_t role,
+                      ipc_wake_cb_t wake_cb, void *wake_ctx)
+{
+    int ret = shm_check_args(sp, name, role);
+    if (ret != ERR_SUCCESS) return ret;
+
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return ERR_MAP_FAILED;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return ERR_MAP_FAILED;
+    }
+    if ((size_t)st.st_size < sizeof(struct ipc_shm_ring)) {
+        close(fd);
+        return ERR_HANDLE_TYPE;
+    }
+    ret = shm_map(sp, fd, (size_t)st.st_size, name, role, wake_cb, wake_ctx);
+    if (ret != ERR_SUCCESS) return ret;
+
+    uint64_t size = sp->ring->size;
+    if (__atomic_load_n(&sp->ring->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC
+        || size < 2 || (size & (size - 1)) != 0
+        || sizeof(struct ipc_shm_ring) + size != sp->map_len) {
+        munmap(sp->ring, sp->map_len);
+        sp->ring = NULL;
+        return ERR_HANDLE_TYPE;
+    }
+    sp->size = (size_t)size;
+    sp->mask = (size_t)size - 1;
+    sp->owner = false;
+    return ERR_SUCCESS;
+}
+
+void ipc_shm_pipe_close(ipc_shm_pipe_t *sp)
+{
+    if (!sp || !sp->ring) return;
+    munmap(sp->ring, sp->map_len);
+    sp->ring = NULL;
+    sp->buf = NULL;
+    if (sp->owner) shm_unlink(sp->name);
+}
+
+size_t ipc_shm_pipe_available(const ipc_shm_pipe_t *sp)
+{
+    if (!sp || !sp->ring) return 0;
+    uint64_t h = __atomic_load_n(&sp->ring->head, __ATOMIC_ACQUIRE);
+    uint64_t t = __atomic_load_n(&sp->ring->tail, __ATOMIC_ACQUIRE);
+    return (size_t)(h - t) & sp->mask;
+}
+
+size_t ipc_shm_pipe_space(const ipc_shm_pipe_t *sp)
+{
+    if (!sp || !sp->ring) return 0;
+    return sp->mask - ipc_shm_pipe_available(sp);
+}
+
+size_t ipc_shm_pipe_write(ipc_shm_pipe_t *sp, const uint8_t *src, size_t len)
+{
+    if (!sp || !sp->ring || !src || len == 0 || sp->role != IPC_SHM_WRITER) return 0;
+    struct ipc_shm_ring *r = sp->ring;
+    size_t h = (size_t)__atomic_load_n(&r->head, __ATOMIC_RELAXED);     /* owned by the writer */
+    size_t t = (size_t)__atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    size_t space = (t - h - 1) & sp->mask;
+    if (len > space) len = space;
+    if (len == 0) return 0;
+
+    size_t first = sp->size - h;
+    if (first > len) first = len;
+    memcpy(&sp->buf[h], src, first);
+    memcpy(&sp->buf[0], src + first, len - first);
+
+    __atomic_store_n(&r->head, (uint64_t)((h + len) & sp->mask), __ATOMIC_RELEASE);
+    shm_notify(&r->reader_waiting, &r->data_seq);
+    return len;
+}
+
+size_t ipc_shm_pipe_read(ipc_shm_pipe_t *sp, uint8_t *dst, size_t len)
+{
+    if (!sp || !sp->ring || !dst || len == 0 || sp->role != IPC_SHM_READER) return 0;
+    struct ipc_shm_ring *r = sp->ring;
+    size_t t = (size_t)__atomic_load_n(&r->tail, __ATOMIC_RELAXED);     /* owned by the reader */
+    size_t h = (size_t)__atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    size_t avail = (h - t) & sp->mask;
+    if (len > avail) len = avail;
+    if (len == 0) return 0;
+
+    size_t first = sp->size - t;
+    if (first > len) first = len;
+    memcpy(dst, &sp->buf[t], first);
+    memcpy(dst + first, &sp->buf[0], len - first);
+
+    __atomic_store_n(&r->tail, (uint64_t)((t + len) & sp->mask), __ATOMIC_RELEASE);
+    shm_notify(&r->writer_waiting, &r->space_seq);
+    return len;
+}
+
+/* Data for the reader, space for the writer */
+static bool shm_ready(const ipc_shm_pipe_t *sp)
+{
+    return (sp->role == IPC_SHM_READER) ? ipc_shm_pipe_available(sp) > 0 : ipc_shm_pipe_space(sp) > 0;
+}
+
+int ipc_shm_pipe_wait(ipc_shm_pipe_t *sp, uint32_t timeout_ms)
+{
+    if (!sp || !sp->ring) return ERR_HANDLE_NULL;
+    struct ipc_shm_ring *r = sp->ring;
+    uint32_t *waiting = (sp->role == IPC_SHM_READER) ? &r->reader_waiting : &r->writer_waiting;
+    uint32_t *seq = (sp->role == IPC_SHM_READER) ? &r->data_seq : &r->space_seq;
+
+    bool ready = shm_ready(sp);
+    if (!ready && timeout_ms > 0) {
+        uint64_t deadline = shm_now_ms() + timeout_ms;
+        for (;;) {
+            uint32_t s = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+            /* flag store before index load; pairs with the fence in shm_notify() */
+            __atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            ready = shm_ready(sp);
+            uint64_t now = shm_now_ms();
+            if (!ready && now < deadline) {
+                shm_futex_wait(seq, s, (uint32_t)(deadline - now));
+                ready = shm_ready(sp);
+            }
+            __atomic_store_n(waiting, 0, __ATOMIC_RELAXED);
+            if (ready || shm_now_ms() >= deadline) break;
+        }
+    }
+    if (!ready) return ERR_CLK_EXPIRED;
+
+    if (sp->wake_cb) {
+        sp->wake_cb(sp->wake_ctx);
+    }
+    return ERR_SUCCESS;
+}
+
+#endif /* IPC_CONF_SHM_PIPE */
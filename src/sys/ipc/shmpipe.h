@@ -0,0 +1,120 @@
+// file: ./src/sys/ipc/shmpipe.h
+#ifndef __IPC_SHMPIPE_H__
+#define __IPC_SHMPIPE_H__ 1
+
+/* Shared-memory pipe between two host processes (POSIX, not AVR).
+ *
+ * A host build of the firmware and a device or plant model running in
+ * another process stream bytes through a ring that lives in a shm_open()
+ * region mapped by both. The ring is a single-producer/single-consumer
+ * pipe like ipc_pipe_init_spsc(): one process writes, the other reads.
+ * head and tail sit on cache lines of their own, so the two sides do not
+ * bounce one line back and forth, and each side reads the other's index
+ * with acquire and publishes its own with release semantics. Reading and
+ * writing make no system calls.
+ *
+ * Wakeups use a futex word in the region (Linux; elsewhere a short sleep).
+ * A side that wants to block sets its waiting flag and sleeps in
+ * ipc_shm_pipe_wait(); the other side calls futex wake only when that flag
+ * is set. When the wait ends because data (reader) or space (writer) is
+ * there, ipc_shm_pipe_wait() calls the local wake_cb, e.g. a process_poll
+ * wrapper, which maps the remote write onto the usual pipe wakeup:
+ *
+ *   ipc_shm_pipe_open(&plant, "/plant-out", IPC_SHM_READER, poll_cb, &sim_process);
+ *   for (;;) {
+ *       process_run();
+ *       ipc_shm_pipe_wait(&plant, idle ? 10 : 0);   // 0: check only, no syscall
+ *   }
+ *
+ * The region starts with a header that holds a magic number and the ring
+ * size, so ipc_shm_pipe_open() needs only the name.
+ *
+ * ipc_shm_pipe_t is a type of its own, not a backend of ipc_pipe_t. An
+ * ipc_pipe_t keeps its indices and wake callbacks in the struct and locks
+ * with CC_ATOMIC_RESTORE(), which only excludes the local process, and a
+ * callback pointer means nothing in the other address space. So fpipe,
+ * mpipe, graph, wire and PipeStream do not work on a shared-memory pipe
+ * directly; a bridge process copies between it and an ordinary pipe.
+ */
+
+#include "../ipc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if IPC_CONF_SHM_PIPE
+
+#if defined(__AVR__)
+#error "IPC_CONF_SHM_PIPE is for host builds only"
+#endif
+
+/* Sides of a shared-memory pipe */
+#define IPC_SHM_WRITER      0
+#define IPC_SHM_READER      1
+
+/* Or-ed into the role of ipc_shm_pipe_create(): remove an existing region
+ * of that name first, e.g. one left behind by a crashed run */
+#define IPC_SHM_REPLACE     0x80
+
+/* Longest region name, including the leading '/' */
+#define IPC_SHM_NAME_MAX    32
+
+/* Layout of the region (header, indices, wakeup words, then the ring) */
+struct ipc_shm_ring;
+
+typedef struct ipc_shm_pipe {
+    struct ipc_shm_ring *ring;    /* mapped region */
+    uint8_t *buf;                 /* ring bytes inside the region */
+    size_t size;                  /* ring size (power of two) */
+    size_t mask;                  /* size - 1 */
+    size_t map_len;               /* bytes mapped */
+    uint8_t role;                 /* IPC_SHM_WRITER or IPC_SHM_READER */
+    bool owner;                   /* created the region, unlinks it on close */
+    ipc_wake_cb_t wake_cb;        /* called by ipc_shm_pipe_wait() when ready (may be NULL) */
+    void *wake_ctx;               /* context passed to wake_cb */
+    char name[IPC_SHM_NAME_MAX];  /* region name */
+} ipc_shm_pipe_t;
+
+/* Create the region name (e.g. "/plant-in") with a ring of size bytes, a
+ * power of two, and map it as role. Returns ERR_SUCCESS, ERR_HANDLE_NULL,
+ * ERR_VAL_RANGE for a bad size or role, ERR_BOUNDS_UPPER for a long name,
+ * ERR_FS_EXIST when the name exists and role has no IPC_SHM_REPLACE, or
+ * ERR_MAP_FAILED.
+ */
+int ipc_shm_pipe_create(ipc_shm_pipe_t *sp, const char *name, size_t size, uint8_t role,
+                        ipc_wake_cb_t wake_cb, void *wake_ctx);
+
+/* Map the region name created by the other process as role.
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL, ERR_VAL_RANGE, ERR_BOUNDS_UPPER,
+ * ERR_MAP_FAILED, or ERR_HANDLE_TYPE when the region is not a pipe.
+ */
+int ipc_shm_pipe_open(ipc_shm_pipe_t *sp, const char *name, uint8_t role,
+                      ipc_wake_cb_t wake_cb, void *wake_ctx);
+
+/* Unmap the region; the creator also removes its name */
+void ipc_shm_pipe_close(ipc_shm_pipe_t *sp);
+
+/* Bytes readable and free space, from either side */
+size_t ipc_shm_pipe_available(const ipc_shm_pipe_t *sp);
+size_t ipc_shm_pipe_space(const ipc_shm_pipe_t *sp);
+
+/* Write up to len bytes (writer) / read up to len bytes (reader).
+ * Return the number of bytes moved; 0 also when called by the wrong side.
+ */
+size_t ipc_shm_pipe_write(ipc_shm_pipe_t *sp, const uint8_t *src, size_t len);
+size_t ipc_shm_pipe_read(ipc_shm_pipe_t *sp, uint8_t *dst, size_t len);
+
+/* Wait up to timeout_ms for data (reader) or space (writer); 0 only checks.
+ * Calls wake_cb when ready. Returns ERR_SUCCESS when ready, ERR_CLK_EXPIRED
+ * on timeout, or ERR_HANDLE_NULL.
+ */
+int ipc_shm_pipe_wait(ipc_shm_pipe_t *sp, uint32_t timeout_ms);
+
+#endif /* IPC_CONF_SHM_PIPE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IPC_SHMPIPE_H__ */
@@ -0,0 +1,125 @@
+// file: ./src/sys/ipc/slab.c
+
+#include "slab.h"
+#include <string.h>
+
+#if IPC_CONF_SLAB
+
+/* -------------------------------------------------------------------------
+ * Slab arena. Declared as an array of pointers so every block is pointer
+ * aligned (all class sizes are multiples of 8). The classes follow each
+ * other in ascending size, so the class of a block is the first class whose
+ * end lies above the block address.
+ * ----------------------------------------------------------------------*/
+
+#define IPC_SLAB_SIZE_(size, count)     size,
+#define IPC_SLAB_COUNT_(size, count)    count,
+
+static void *slab_arena[(IPC_SLAB_ARENA_SIZE + sizeof(void*) - 1) / sizeof(void*)];
+
+static const uint8_t slab_size[IPC_SLAB_NUM_CLASSES] = { IPC_SLAB_CLASSES(IPC_SLAB_SIZE_) };
+static const uint16_t slab_count[IPC_SLAB_NUM_CLASSES] = { IPC_SLAB_CLASSES(IPC_SLAB_COUNT_) };
+
+static struct ipc_pool slab_pool[IPC_SLAB_NUM_CLASSES];
+#if IPC_CONF_POOL_OWNER
+static uint8_t slab_owners[IPC_SLAB_NUM_BLOCKS];
+#endif
+static const uint8_t *slab_end[IPC_SLAB_NUM_CLASSES];
+
+static struct {
+    uint16_t min_free;
+    uint32_t allocs;
+    uint32_t spills;
+    uint32_t fails;
+} slab_ctr[IPC_SLAB_NUM_CLASSES];
+
+int ipc_slab_init(void)
+{
+    uint8_t *base = (uint8_t*)slab_arena;
+#if IPC_CONF_POOL_OWNER
+    uint8_t *owners = slab_owners;
+#endif
+    for (uint8_t c = 0; c < IPC_SLAB_NUM_CLASSES; ++c) {
+        if (slab_count[c] > 0) {
+            ipc_pool_init(&slab_pool[c], base, slab_size[c], slab_count[c]);
+#if IPC_CONF_POOL_OWNER
+            ipc_pool_track(&slab_pool[c], owners);
+            owners += slab_count[c];
+#endif
+        }
+        else {
+            /* an empty class never hands out blocks */
+            memset(&slab_pool[c], 0, sizeof(slab_pool[c]));
+            slab_pool[c].block_size = slab_size[c];
+        }
+        base += (size_t)slab_size[c] * slab_count[c];
+        slab_end[c] = base;
+        slab_ctr[c].min_free = slab_count[c];
+        slab_ctr[c].allocs = 0;
+        slab_ctr[c].spills = 0;
+        slab_ctr[c].fails = 0;
+    }
+    return ERR_SUCCESS;
+}
+
+void *ipc_alloc(size_t size)
+{
+    if (size == 0 || size > IPC_SLAB_MAX_SIZE) return NULL;
+
+    uint8_t want = 0;
+    while (slab_size[want] < size) ++want;
+
+    /* fall back to larger classes when the best fit is exhausted */
+    void *blk = NULL;
+    uint8_t c;
+    for (c = want; c < IPC_SLAB_NUM_CLASSES; ++c) {
+        if ((blk = ipc_pool_alloc(&slab_pool[c])) != NULL) break;
+    }
+
+    CC_ATOMIC_RESTORE() {
+        if (blk) {
+            slab_ctr[c].allocs++;
+            if (c != want) slab_ctr[want].spills++;
+            if (slab_pool[c].free_count < slab_ctr[c].min_free)
+                slab_ctr[c].min_free = slab_pool[c].free_count;
+        }
+        else {
+            slab_ctr[want].fails++;
+        }
+    }
+    return blk;
+}
+
+struct ipc_pool *ipc_slab_pool_of(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t*)ptr;
+    if (!p || p < (const uint8_t*)slab_arena) return NULL;
+    for (uint8_t c = 0; c < IPC_SLAB_NUM_CLASSES; ++c) {
+        if (p < slab_end[c]) return &slab_pool[c];
+    }
+    return NULL;
+}
+
+void ipc_free(void *ptr)
+{
+    struct ipc_pool *pool = ipc_slab_pool_of(ptr);
+    if (pool) ipc_pool_free(pool, ptr);
+}
+
+int ipc_slab_stats(uint8_t cls, struct ipc_slab_stats *st)
+{
+    if (!st) return ERR_HANDLE_NULL;
+    if (cls >= IPC_SLAB_NUM_CLASSES) return ERR_VAL_RANGE;
+    CC_ATOMIC_RESTORE() {
+        st->block_size = slab_size[cls];
+        st->n_blocks = slab_count[cls];
+        st->free_count = slab_pool[cls].free_count;
+        st->min_free = slab_ctr[cls].min_free;
+        st->allocs = slab_ctr[cls].allocs;
+        st->spills = slab_ctr[cls].spills;
+        st->fails = slab_ctr[cls].fails;
+    }
+    return ERR_SUCCESS;
+}
+
+#endif /* IPC_CONF_SLAB */
@@ -0,0 +1,87 @@
+// file: ./src/sys/ipc/slab.h
+#ifndef __IPC_SLAB_H__
+#define __IPC_SLAB_H__ 1
+
+/* Size-class slab allocator on top of ipc_pool.
+ *
+ * One static arena is carved into a fixed number of size classes (8, 16, 32,
+ * 64 and 128 bytes), each managed by its own ipc_pool. ipc_alloc(size) takes
+ * a block from the smallest class that fits and has a free block; ipc_free(ptr)
+ * finds the class from the address range of the pointer, so callers do not
+ * need to remember which pool a block came from. Both are O(1) (a bounded
+ * scan over the classes) and ISR-safe, like ipc_pool_alloc()/ipc_pool_free().
+ *
+ * The layout of the arena is fixed at compile time by IPC_SLAB_CLASSES() and
+ * the IPC_CONF_SLAB_<size> block counts in ipc.conf.h. Enable the allocator
+ * with IPC_CONF_SLAB; protoduino_start() initializes it. With
+ * IPC_CONF_POOL_OWNER the class pools are tracked, so blocks left behind by
+ * an exited process are reclaimed.
+ */
+
+#include "../ipc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if IPC_CONF_SLAB
+
+/* Layout of the slab arena: X(block size, block count) per size class, in
+ * ascending block size. The classes are placed in the arena in this order.
+ */
+#define IPC_SLAB_CLASSES(X)             \
+    X(8,   IPC_CONF_SLAB_8)             \
+    X(16,  IPC_CONF_SLAB_16)            \
+    X(32,  IPC_CONF_SLAB_32)            \
+    X(64,  IPC_CONF_SLAB_64)            \
+    X(128, IPC_CONF_SLAB_128)
+
+#define IPC_SLAB_BYTES_(size, count)    + (size) * (count)
+#define IPC_SLAB_ONE_(size, count)      + 1
+#define IPC_SLAB_COUNT_SUM_(size, count) + (count)
+
+/* Size of the arena in bytes, number of size classes and of blocks */
+#define IPC_SLAB_ARENA_SIZE   (0 IPC_SLAB_CLASSES(IPC_SLAB_BYTES_))
+#define IPC_SLAB_NUM_CLASSES  (0 IPC_SLAB_CLASSES(IPC_SLAB_ONE_))
+#define IPC_SLAB_NUM_BLOCKS   (0 IPC_SLAB_CLASSES(IPC_SLAB_COUNT_SUM_))
+
+/* Largest block ipc_alloc() can return */
+#define IPC_SLAB_MAX_SIZE     128
+
+/* Per-class statistics */
+struct ipc_slab_stats {
+    size_t block_size;    /* size of the blocks in this class */
+    uint16_t n_blocks;    /* blocks in this class */
+    uint16_t free_count;  /* blocks free now */
+    uint16_t min_free;    /* lowest free_count since init */
+    uint32_t allocs;      /* blocks handed out from this class */
+    uint32_t spills;      /* requests for this class served by a larger class */
+    uint32_t fails;       /* requests for this class that found no block at all */
+};
+
+/* Carve the arena into its size classes. Returns ERR_SUCCESS. */
+int ipc_slab_init(void);
+
+/* Allocate a block of at least size bytes, or NULL when size is 0, larger than
+ * IPC_SLAB_MAX_SIZE, or all fitting classes are exhausted.
+ */
+void *ipc_alloc(size_t size);
+
+/* Free a block from ipc_alloc() (no-op for NULL or pointers outside the arena) */
+void ipc_free(void *ptr);
+
+/* The class pool that owns ptr, or NULL when ptr is outside the arena */
+struct ipc_pool *ipc_slab_pool_of(const void *ptr);
+
+/* Copy the statistics of class cls (0 .. IPC_SLAB_NUM_CLASSES - 1).
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL or ERR_VAL_RANGE.
+ */
+int ipc_slab_stats(uint8_t cls, struct ipc_slab_stats *st);
+
+#endif /* IPC_CONF_SLAB */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IPC_SLAB_H__ */
@@ -0,0 +1,379 @@
+// file: ./src/sys/ipc/wire.c
+
+#include "wire.h"
+#include <string.h>
+
+/* -------------------------------------------------------------------------
+ * Encoder. The frame size is computed first, so the encoder can check the
+ * space of the sink and then write without failing halfway. Bytes go out
+ * through a small writer that either calls the sink per byte or fills the
+ * write spans of a pipe.
+ * ----------------------------------------------------------------------*/
+
+struct wire_out {
+    const ipc_wire_sink_t *sink;  /* byte sink, or NULL for a pipe */
+    ipc_pipe_t *pipe;
+    uint8_t *start;               /* current write span of the pipe */
+    uint8_t *w;                   /* next byte in it */
+    size_t span;                  /* bytes left in it */
+};
+
+static size_t varint_size(uintptr_t v)
+{
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static uintptr_t zigzag(intptr_t v)
+{
+    return ((uintptr_t)v << 1) ^ (uintptr_t)(v < 0 ? -1 : 0);
+}
+
+static intptr_t unzigzag(uintptr_t v)
+{
+    return (intptr_t)(v >> 1) ^ -(intptr_t)(v & 1);
+}
+
+static void out_byte(struct wire_out *o, uint8_t b)
+{
+    if (o->sink) {
+        o->sink->put(b);
+        return;
+    }
+    if (o->span == 0) {
+        ipc_pipe_write_reserve(o->pipe, &o->start, &o->span);
+        o->w = o->start;
+    }
+    *o->w++ = b;
+    if (--o->span == 0) {
+        /* commit per span; the reader may see the first part of a frame early */
+        ipc_pipe_write_commit(o->pipe, (size_t)(o->w - o->start));
+    }
+}
+
+static void out_varint(struct wire_out *o, uintptr_t v)
+{
+    while (v >= 0x80) {
+        out_byte(o, (uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out_byte(o, (uint8_t)v);
+}
+
+/* Bytes of the frame after the length field */
+static size_t body_size(const ipc_wire_schema_t *s, uint8_t dest, const ipc_msg_t *m)
+{
+    size_t n = varint_size(dest) + varint_size(m->type);
+    for (uint8_t i = 0; i < s->argc; ++i) {
+        const void *a = m->argv[i];
+        switch (s->kind[i]) {
+        case IPC_WIRE_UINT: n += varint_size((uintptr_t)a); break;
+        case IPC_WIRE_INT:  n += varint_size(zigzag((intptr_t)a)); break;
+        case IPC_WIRE_STR: {
+            size_t len = a ? strlen((const char*)a) : 0;
+            n += varint_size(len) + len;
+            break;
+        }
+        case IPC_WIRE_BLOB: n += s->len[i]; break;
+        default: break;
+        }
+    }
+    return n;
+}
+
+static void write_frame(struct wire_out *o, const ipc_wire_schema_t *s, uint8_t dest, const ipc_msg_t *m,
+                        size_t body)
+{
+    out_varint(o, body);
+    out_varint(o, dest);
+    out_varint(o, m->type);
+    for (uint8_t i = 0; i < s->argc; ++i) {
+        const uint8_t *a = (const uint8_t*)m->argv[i];
+        switch (s->kind[i]) {
+        case IPC_WIRE_UINT: out_varint(o, (uintptr_t)a); break;
+        case IPC_WIRE_INT:  out_varint(o, zigzag((intptr_t)a)); break;
+        case IPC_WIRE_STR: {
+            size_t len = a ? strlen((const char*)a) : 0;
+            out_varint(o, len);
+            for (size_t k = 0; k < len; ++k) out_byte(o, a[k]);
+            break;
+        }
+        case IPC_WIRE_BLOB:
+            for (uint8_t k = 0; k < s->len[i]; ++k) out_byte(o, a ? a[k] : 0);
+            break;
+        default: break;
+        }
+    }
+}
+
+const ipc_wire_schema_t *ipc_wire_schema_find(const ipc_wire_schema_t *table, uint8_t n, uint8_t type)
+{
+    if (!table) return NULL;
+    for (uint8_t i = 0; i < n; ++i) {
+        if (table[i].type == type) return &table[i];
+    }
+    return NULL;
+}
+
+size_t ipc_wire_size(const ipc_wire_schema_t *table, uint8_t n, uint8_t dest, const ipc_msg_t *m)
+{
+    if (!m) return 0;
+    const ipc_wire_schema_t *s = ipc_wire_schema_find(table, n, m->type);
+    if (!s) return 0;
+    size_t body = body_size(s, dest, m);
+    return varint_size(body) + body;
+}
+
+int ipc_wire_encode(const ipc_wire_schema_t *table, uint8_t n, uint8_t dest, const ipc_msg_t *m,
+                    const ipc_wire_sink_t *out)
+{
+    if (!m || !out || !out->space || !out->put) return ERR_HANDLE_NULL;
+    const ipc_wire_schema_t *s = ipc_wire_schema_find(table, n, m->type);
+    if (!s) return ERR_STRUCT_TYPE;
+    size_t body = body_size(s, dest, m);
+    if (varint_size(body) + body > out->space()) return ERR_PIPE_FULL;
+
+    struct wire_out o = { out, NULL, NULL, NULL, 0 };
+    write_frame(&o, s, dest, m, body);
+    return ERR_SUCCESS;
+}
+
+int ipc_wire_encode_pipe(const ipc_wire_schema_t *table, uint8_t n, uint8_t dest, const ipc_msg_t *m,
+                         ipc_pipe_t *p)
+{
+    if (!m || !p) return ERR_HANDLE_NULL;
+    const ipc_wire_schema_t *s = ipc_wire_schema_find(table, n, m->type);
+    if (!s) return ERR_STRUCT_TYPE;
+    size_t body = body_size(s, dest, m);
+    if (varint_size(body) + body > ipc_pipe_space(p)) return ERR_PIPE_FULL;
+
+    struct wire_out o = { NULL, p, NULL, NULL, 0 };
+    write_frame(&o, s, dest, m, body);
+    if (o.span > 0) ipc_pipe_write_commit(p, (size_t)(o.w - o.start));
+    return ERR_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------
+ * Decoder. A state machine over single bytes; remain counts the bytes of
+ * the frame body still to come, so a frame that is dropped can be skipped
+ * without understanding it.
+ * ----------------------------------------------------------------------*/
+
+#define WIRE_LEN    0   /* frame length varint */
+#define WIRE_DEST   1   /* destination varint */
+#define WIRE_TYPE   2   /* type varint */
+#define WIRE_VAL    3   /* integer or string length varint */
+#define WIRE_BYTES  4   /* string or blob bytes */
+#define WIRE_SKIP   5   /* rest of a dropped frame */
+
+int ipc_wire_decoder_init(ipc_wire_decoder_t *d, const ipc_wire_schema_t *table, uint8_t n,
+                          struct ipc_pool *msg_pool, struct ipc_pool *data_pool)
+{
+    if (!d || !table || !msg_pool) return ERR_HANDLE_NULL;
+    memset(d, 0, sizeof(*d));
+    d->table = table;
+    d->n = n;
+    d->msg_pool = msg_pool;
+    d->data_pool = data_pool;
+    d->state = WIRE_LEN;
+    return ERR_SUCCESS;
+}
+
+void ipc_wire_free(ipc_wire_decoder_t *d, ipc_msg_t *m)
+{
+    if (!d || !m) return;
+    const ipc_wire_schema_t *s = ipc_wire_schema_find(d->table, d->n, m->type);
+    for (uint8_t i = 0; s && i < s->argc; ++i) {
+        if ((s->kind[i] == IPC_WIRE_STR || s->kind[i] == IPC_WIRE_BLOB) && m->argv[i]) {
+            ipc_pool_free(d->data_pool, m->argv[i]);
+        }
+    }
+    ipc_msg_free_to_pool(d->msg_pool, m);
+}
+
+/* Drop the frame being read */
+static int wire_drop(ipc_wire_decoder_t *d, int err)
+{
+    if (d->msg) {
+        /* slots not read yet are still NULL */
+        ipc_wire_free(d, d->msg);
+        d->msg = NULL;
+    }
+    d->acc = 0;
+    d->shift = 0;
+    d->errors++;
+    d->state = d->remain ? WIRE_SKIP : WIRE_LEN;
+    return err;
+}
+
+/* Read one varint byte; true when the varint is complete in d->acc */
+static bool wire_varint(ipc_wire_decoder_t *d, uint8_t b, bool *bad)
+{
+    if (d->shift >= sizeof(uintptr_t) * 8) {
+        *bad = true;
+        return false;
+    }
+    d->acc |= (uintptr_t)(b & 0x7F) << d->shift;
+    d->shift += 7;
+    return (b & 0x80) == 0;
+}
+
+/* Start a string or blob of d->len bytes */
+static int wire_start_bytes(ipc_wire_decoder_t *d)
+{
+    size_t need = d->len + (d->schema->kind[d->arg] == IPC_WIRE_STR ? 1 : 0);
+    if (!d->data_pool || need > d->data_pool->block_size) return ERR_MSG_SIZE;
+    uint8_t *blk = (uint8_t*)ipc_pool_alloc(d->data_pool);
+    if (!blk) return ERR_MEM_ALLOC;
+    d->msg->argv[d->arg] = blk;
+    d->pos = 0;
+    d->state = WIRE_BYTES;
+    return ERR_SUCCESS;
+}
+
+/* Move to the next slot that is sent, or finish the message */
+static int wire_next_arg(ipc_wire_decoder_t *d)
+{
+    const ipc_wire_schema_t *s = d->schema;
+    while (d->arg < s->argc && (s->kind[d->arg] == IPC_WIRE_NONE ||
+                                (s->kind[d->arg] == IPC_WIRE_BLOB && s->len[d->arg] == 0))) {
+        d->arg++;
+    }
+    d->state = WIRE_VAL;
+    if (d->arg < s->argc && s->kind[d->arg] == IPC_WIRE_BLOB) {
+        d->len = s->len[d->arg];
+        return wire_start_bytes(d);
+    }
+    return ERR_SUCCESS;
+}
+
+int ipc_wire_decode(ipc_wire_decoder_t *d, uint8_t b, ipc_msg_t **msg, uint8_t *dest)
+{
+    if (!d || !msg || !dest) return ERR_HANDLE_NULL;
+    *msg = NULL;
+    bool bad = false;
+    int err = ERR_SUCCESS;
+
+    if (d->state == WIRE_LEN) {
+        if (!wire_varint(d, b, &bad)) {
+            if (bad) {
+                d->acc = 0;
+                d->shift = 0;
+                d->errors++;
+                return ERR_STRUCT_PARSE;
+            }
+            return ERR_SUCCESS;
+        }
+        if (d->acc > UINT16_MAX) {
+            d->acc = 0;
+            d->shift = 0;
+            d->errors++;
+            return ERR_MSG_SIZE;
+        }
+        d->remain = (uint16_t)d->acc;
+        d->acc = 0;
+        d->shift = 0;
+        if (d->remain > 0) d->state = WIRE_DEST;
+        return ERR_SUCCESS;
+    }
+
+    d->remain--;
+    switch (d->state) {
+    case WIRE_SKIP:
+        if (d->remain == 0) d->state = WIRE_LEN;
+        return ERR_SUCCESS;
+
+    case WIRE_BYTES: {
+        uint8_t *data = (uint8_t*)d->msg->argv[d->arg];
+        data[d->pos++] = b;
+        if (d->pos == d->len) {
+            if (d->schema->kind[d->arg] == IPC_WIRE_STR) data[d->pos] = 0;
+            d->arg++;
+            err = wire_next_arg(d);
+        }
+        break;
+    }
+
+    default: {
+        if (!wire_varint(d, b, &bad)) {
+            if (bad) return wire_drop(d, ERR_STRUCT_PARSE);
+            if (d->remain == 0) return wire_drop(d, ERR_STRUCT_PARSE);
+            return ERR_SUCCESS;
+        }
+        uintptr_t v = d->acc;
+        d->acc = 0;
+        d->shift = 0;
+
+        if (d->state == WIRE_DEST) {
+            if (v > UINT8_MAX) return wire_drop(d, ERR_STRUCT_PARSE);
+            d->dest = (uint8_t)v;
+            d->state = WIRE_TYPE;
+        }
+        else if (d->state == WIRE_TYPE) {
+            d->schema = (v <= UINT8_MAX) ? ipc_wire_schema_find(d->table, d->n, (uint8_t)v) : NULL;
+            if (!d->schema) return wire_drop(d, ERR_STRUCT_TYPE);
+            d->msg = ipc_msg_alloc_from_pool(d->msg_pool);
+            if (!d->msg) return wire_drop(d, ERR_MEM_ALLOC);
+            ipc_msg_init(d->msg, d->schema->type, d->schema->argc, NULL);
+            d->arg = 0;
+            err = wire_next_arg(d);
+        }
+        else {
+            uint8_t kind = d->schema->kind[d->arg];
+            if (kind == IPC_WIRE_STR) {
+                if (v > UINT16_MAX) return wire_drop(d, ERR_MSG_SIZE);
+                d->len = (uint16_t)v;
+                err = wire_start_bytes(d);
+                if (err == ERR_SUCCESS && d->len == 0) {
+                    *(uint8_t*)d->msg->argv[d->arg] = 0;
+                    d->arg++;
+                    err = wire_next_arg(d);
+                }
+            }
+            else {
+                d->msg->argv[d->arg] = (kind == IPC_WIRE_INT) ? (void*)unzigzag(v) : (void*)v;
+                d->arg++;
+                err = wire_next_arg(d);
+            }
+        }
+        break;
+    }
+    }
+
+    if (err != ERR_SUCCESS) return wire_drop(d, err);
+
+    bool complete = d->msg && d->arg >= d->schema->argc;
+    if (complete != (d->remain == 0)) {
+        /* the frame is shorter or longer than its schema says */
+        return wire_drop(d, ERR_STRUCT_PARSE);
+    }
+    if (complete) {
+        *msg = d->msg;
+        *dest = d->dest;
+        d->msg = NULL;
+        d->state = WIRE_LEN;
+    }
+    return ERR_SUCCESS;
+}
+
+int ipc_wire_decode_pipe(ipc_wire_decoder_t *d, ipc_pipe_t *p, ipc_msg_t **msg, uint8_t *dest)
+{
+    if (!d || !p || !msg || !dest) return ERR_HANDLE_NULL;
+    *msg = NULL;
+    for (;;) {
+        const uint8_t *r;
+        size_t avail, used = 0;
+        int ret = ERR_SUCCESS;
+        ipc_pipe_read_peek(p, &r, &avail);
+        if (avail == 0) return ERR_SUCCESS;
+        while (used < avail && ret == ERR_SUCCESS && *msg == NULL) {
+            ret = ipc_wire_decode(d, r[used++], msg, dest);
+        }
+        ipc_pipe_read_consume(p, used);
+        if (ret != ERR_SUCCESS || *msg != NULL) return ret;
+    }
+}
@@ -0,0 +1,119 @@
+// file: ./src/sys/ipc/wire.h
+#ifndef __IPC_WIRE_H__
+#define __IPC_WIRE_H__ 1
+
+/* Compact binary encoding of ipc_msg_t for links like the UART.
+ *
+ * argv[] holds pointers, which mean nothing on the other end of a wire. A
+ * schema per message type tells the codec what each argv slot carries:
+ * an integer stored in the pointer itself, a NUL-terminated string, or a
+ * blob of fixed size. A message is sent as one frame of varints:
+ *
+ *   frame  := len dest type arg*        (len = bytes after the len field)
+ *   UINT   := varint                    (LEB128, 7 bits per byte)
+ *   INT    := varint of the zigzag value
+ *   STR    := varint n, n bytes         (without the NUL)
+ *   BLOB   := schema len bytes
+ *
+ * dest is a small number that addresses a process on the receiving side,
+ * so a message with two small integers costs 6 bytes on the wire.
+ *
+ * The encoder checks the space first and then writes the frame straight
+ * into the serial TX ring (through an ipc_wire_sink_t) or into an ipc_pipe,
+ * all-or-nothing. The decoder is fed one byte at a time, e.g. from a serial
+ * RX callback or from a pipe, and builds the message in place: the message
+ * comes from a message pool, strings and blobs from a data pool. Frames
+ * with an unknown type, a bad layout or no free block are skipped as a
+ * whole, thanks to the length prefix.
+ */
+
+#include "../ipc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Kinds of argv slots */
+#define IPC_WIRE_NONE   0     /* slot is not sent (decoded as NULL) */
+#define IPC_WIRE_UINT   1     /* unsigned integer cast to void* */
+#define IPC_WIRE_INT    2     /* signed integer cast to void* */
+#define IPC_WIRE_STR    3     /* pointer to a NUL-terminated string */
+#define IPC_WIRE_BLOB   4     /* pointer to len[] bytes */
+
+/* Layout of one message type */
+typedef struct ipc_wire_schema {
+    uint8_t type;                     /* ipc_msg_t.type described by this entry */
+    uint8_t argc;                     /* argv slots that are sent */
+    uint8_t kind[IPC_MSG_MAX_ARGS];   /* IPC_WIRE_* per slot */
+    uint8_t len[IPC_MSG_MAX_ARGS];    /* size of IPC_WIRE_BLOB slots */
+} ipc_wire_schema_t;
+
+/* Byte sink for the encoder. The members have the signatures of
+ * serial[0..3]_write_available() and serial[0..3]_write8(), so a serial
+ * port is used with IPC_WIRE_SERIAL(0).
+ */
+typedef struct ipc_wire_sink {
+    uint_fast8_t (*space)(void);
+    uint_fast8_t (*put)(const uint_fast8_t b);
+} ipc_wire_sink_t;
+
+#define IPC_WIRE_SERIAL(n) { serial##n##_write_available, serial##n##_write8 }
+
+/* Schema of type in table (n entries), or NULL */
+const ipc_wire_schema_t *ipc_wire_schema_find(const ipc_wire_schema_t *table, uint8_t n, uint8_t type);
+
+/* Encoded size of m for dest in bytes, 0 when m has no schema in table */
+size_t ipc_wire_size(const ipc_wire_schema_t *table, uint8_t n, uint8_t dest, const ipc_msg_t *m);
+
+/* Encode m for dest into out, or into the pipe p. All-or-nothing.
+ * Returns ERR_SUCCESS, ERR_HANDLE_NULL, ERR_STRUCT_TYPE when m->type has no
+ * schema, or ERR_PIPE_FULL when the frame does not fit right now.
+ */
+int ipc_wire_encode(const ipc_wire_schema_t *table, uint8_t n, uint8_t dest, const ipc_msg_t *m,
+                    const ipc_wire_sink_t *out);
+int ipc_wire_encode_pipe(const ipc_wire_schema_t *table, uint8_t n, uint8_t dest, const ipc_msg_t *m,
+                         ipc_pipe_t *p);
+
+/* Streaming decoder state */
+typedef struct ipc_wire_decoder {
+    const ipc_wire_schema_t *table;   /* schemas */
+    uint8_t n;                        /* entries in table */
+    struct ipc_pool *msg_pool;        /* decoded messages */
+    struct ipc_pool *data_pool;       /* strings and blobs (NULL: such frames are dropped) */
+    uint8_t state;                    /* internal */
+    uint8_t shift;                    /* bit position in the varint being read */
+    uintptr_t acc;                    /* varint being read */
+    uint16_t remain;                  /* bytes of the frame not read yet */
+    uint8_t dest;                     /* destination of the frame */
+    uint8_t arg;                      /* argv slot being read */
+    uint16_t len;                     /* size of the string/blob being read */
+    uint16_t pos;                     /* bytes of it read */
+    const ipc_wire_schema_t *schema;  /* schema of the frame */
+    ipc_msg_t *msg;                   /* message being built */
+    uint16_t errors;                  /* frames dropped since init */
+} ipc_wire_decoder_t;
+
+/* Initialize a decoder. Returns ERR_SUCCESS or ERR_HANDLE_NULL. */
+int ipc_wire_decoder_init(ipc_wire_decoder_t *d, const ipc_wire_schema_t *table, uint8_t n,
+                          struct ipc_pool *msg_pool, struct ipc_pool *data_pool);
+
+/* Feed one byte. When it completes a message, *msg and *dest are set;
+ * otherwise *msg is NULL. Returns ERR_SUCCESS, or the reason a frame is
+ * dropped: ERR_STRUCT_TYPE, ERR_STRUCT_PARSE, ERR_MEM_ALLOC or ERR_MSG_SIZE.
+ * The rest of a dropped frame is skipped.
+ */
+int ipc_wire_decode(ipc_wire_decoder_t *d, uint8_t b, ipc_msg_t **msg, uint8_t *dest);
+
+/* Feed bytes from the pipe p until a message is complete or p is empty.
+ * Same results as ipc_wire_decode().
+ */
+int ipc_wire_decode_pipe(ipc_wire_decoder_t *d, ipc_pipe_t *p, ipc_msg_t **msg, uint8_t *dest);
+
+/* Free a decoded message with its strings and blobs */
+void ipc_wire_free(ipc_wire_decoder_t *d, ipc_msg_t *m);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IPC_WIRE_H__ */
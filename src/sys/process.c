@@ -1,6 +1,16 @@
 // file: ./src/sys/process.c
 #include "process.h"
 #include "ipc.h"
+#if IPC_CONF_RPC
+#include "ipc/rpc.h"
+#endif
+#if IPC_CONF_BUS
+#include "ipc/bus.h"
+#endif
+#if IPC_CONF_TIMESTAMP
+#include "ipc/latency.h"
+#include "clock.h"
+#endif
 #include <string.h>
 
 /* Internal event entry */
@@ -9,6 +19,10 @@ struct process_event_entry
   struct process *dest; /* NULL => broadcast */
   process_event_t ev;
   process_data_t data;
+#if IPC_CONF_TIMESTAMP
+  uint32_t stamp;       /* clock_time() of the post */
+  struct process *src;  /* posting process, NULL from ISR */
+#endif
 };
 
 /* Global ring event queue */
@@ -22,6 +36,9 @@ static struct process *process_list = NULL;
 /* Poll request flag */
 static volatile uint8_t poll_requested = 0;
 
+/* Process whose protothread is running */
+struct process *process_current = NULL;
+
 /* Optional logger for errors */
 static struct process *process_error_logger = NULL;
 
@@ -30,19 +47,48 @@ static struct process *process_error_logger = NULL;
 static struct error_info error_pool[ERROR_INFO_POOL_SIZE];
 static uint8_t error_pool_idx = 0;
 
+#if IPC_CONF_TIMESTAMP
+/* Post time of the event being handled, see process_event_age() */
+static uint32_t event_stamp = 0;
+#endif
+
+#if IPC_CONF_POOL_OWNER
+/* Rotating pool for reclaim_info posted to the logger */
+#define RECLAIM_INFO_POOL_SIZE 2
+static struct reclaim_info reclaim_pool[RECLAIM_INFO_POOL_SIZE];
+static uint8_t reclaim_pool_idx = 0;
+#endif
+
 /* ---------------- internal helpers ---------------- */
 
+#if PROCESS_CONF_COND
+/* Remove p from the waiters of the condition it is parked on (caller must ensure atomic) */
+static void cond_unlink_nolock(struct process *p)
+{
+  struct process **q = &p->waiting_on->waiters;
+  while (*q)
+  {
+    if (*q == p)
+    {
+      *q = p->cond_next;
+      break;
+    }
+    q = &((*q)->cond_next);
+  }
+  p->waiting_on = NULL;
+  p->cond_next = NULL;
+}
+#endif
+
 /* Non-atomic enqueue (caller must ensure atomic) */
-static int enqueue_event_nolock(struct process *p, process_event_t ev, process_data_t data)
+static int enqueue_event_nolock(const struct process_event_entry *e)
 {
   process_num_events_t next = (event_head + 1) % PROCESS_CONF_EVENT_QUEUE_SIZE;
   if (next == event_tail)
   {
     return 0; /* full */
   }
-  events[event_head].dest = p;
-  events[event_head].ev = ev;
-  events[event_head].data = data;
+  events[event_head] = *e;
   event_head = next;
   return 1;
 }
@@ -59,56 +105,202 @@ static int dequeue_event_nolock(struct process_event_entry *out)
 
 /* Per-process inbox utilities (if enabled) */
 #if PROCESS_CONF_PER_PROCESS_INBOX
-static int process_inbox_push(struct process *p, process_event_t ev, process_data_t data)
+/* Each lane is a ring of its own inside the inbox arrays */
+static const uint8_t inbox_lane_size[PROCESS_CONF_INBOX_LANES] = {
+  PROCESS_CONF_INBOX_LANE0_SIZE,
+#if PROCESS_CONF_INBOX_LANES > 1
+  PROCESS_CONF_INBOX_LANE1_SIZE,
+#endif
+#if PROCESS_CONF_INBOX_LANES > 2
+  PROCESS_CONF_INBOX_LANE2_SIZE,
+#endif
+#if PROCESS_CONF_INBOX_LANES > 3
+  PROCESS_CONF_INBOX_LANE3_SIZE,
+#endif
+};
+
+static const uint8_t inbox_lane_base[PROCESS_CONF_INBOX_LANES] = {
+  0,
+#if PROCESS_CONF_INBOX_LANES > 1
+  PROCESS_CONF_INBOX_LANE0_SIZE,
+#endif
+#if PROCESS_CONF_INBOX_LANES > 2
+  PROCESS_CONF_INBOX_LANE0_SIZE + PROCESS_CONF_INBOX_LANE1_SIZE,
+#endif
+#if PROCESS_CONF_INBOX_LANES > 3
+  PROCESS_CONF_INBOX_LANE0_SIZE + PROCESS_CONF_INBOX_LANE1_SIZE + PROCESS_CONF_INBOX_LANE2_SIZE,
+#endif
+};
+
+static int process_inbox_push(struct process *p, uint8_t lane, const struct process_event_entry *e)
 {
   if (!p)
     return 0;
-#if PROCESS_CONF_INBOX_POINTERS
-  uint8_t next = (uint8_t)((p->inbox_head + 1) % PROCESS_CONF_INBOX_SIZE);
-  if (next == p->inbox_tail)
+  uint8_t next = (uint8_t)((p->inbox_head[lane] + 1) % inbox_lane_size[lane]);
+  if (next == p->inbox_tail[lane])
+  {
+    p->inbox_overflow[lane]++;
     return 0; /* full */
-  p->inbox_ev[p->inbox_head] = ev;
-  p->inbox_data[p->inbox_head] = data;
-  p->inbox_head = next;
-  return 1;
+  }
+  uint8_t slot = (uint8_t)(inbox_lane_base[lane] + p->inbox_head[lane]);
+#if PROCESS_CONF_INBOX_POINTERS
+  p->inbox_ev[slot] = e->ev;
+  p->inbox_data[slot] = e->data;
+#if IPC_CONF_TIMESTAMP
+  p->inbox_stamp[slot] = e->stamp;
+  p->inbox_src[slot] = e->src;
+#endif
 #else
-  uint8_t next = (uint8_t)((p->inbox_head + 1) % PROCESS_CONF_INBOX_SIZE);
-  if (next == p->inbox_tail)
-    return 0; /* full */
-  p->inbox[p->inbox_head].ev = ev;
-  p->inbox[p->inbox_head].data = data;
-  p->inbox_head = next;
-  return 1;
+  p->inbox[slot].ev = e->ev;
+  p->inbox[slot].data = e->data;
+#if IPC_CONF_TIMESTAMP
+  p->inbox[slot].stamp = e->stamp;
+  p->inbox[slot].src = e->src;
+#endif
 #endif
+  p->inbox_head[lane] = next;
+  return 1;
 }
 
-static int process_inbox_pop(struct process *p, struct process_event_entry *out)
+static int process_inbox_pop(struct process *p, uint8_t lane, struct process_event_entry *out)
 {
   if (!p)
     return 0;
-  if (p->inbox_head == p->inbox_tail)
+  if (p->inbox_head[lane] == p->inbox_tail[lane])
     return 0; /* empty */
+  uint8_t slot = (uint8_t)(inbox_lane_base[lane] + p->inbox_tail[lane]);
 #if PROCESS_CONF_INBOX_POINTERS
-  out->ev = p->inbox_ev[p->inbox_tail];
-  out->data = p->inbox_data[p->inbox_tail];
+  out->ev = p->inbox_ev[slot];
+  out->data = p->inbox_data[slot];
+#if IPC_CONF_TIMESTAMP
+  out->stamp = p->inbox_stamp[slot];
+  out->src = p->inbox_src[slot];
+#endif
 #else
-  out->ev = p->inbox[p->inbox_tail].ev;
-  out->data = p->inbox[p->inbox_tail].data;
+  out->ev = p->inbox[slot].ev;
+  out->data = p->inbox[slot].data;
+#if IPC_CONF_TIMESTAMP
+  out->stamp = p->inbox[slot].stamp;
+  out->src = p->inbox[slot].src;
+#endif
 #endif
   out->dest = p;
-  p->inbox_tail = (uint8_t)((p->inbox_tail + 1) % PROCESS_CONF_INBOX_SIZE);
+  p->inbox_tail[lane] = (uint8_t)((p->inbox_tail[lane] + 1) % inbox_lane_size[lane]);
   return 1;
 }
 #endif /* PROCESS_CONF_PER_PROCESS_INBOX */
 
+#if IPC_CONF_MSG_REFCOUNT
+/* The reference-counted message carried by an event, or NULL */
+static ipc_msg_t *event_shared_msg(process_event_t ev, process_data_t data)
+{
+  ipc_msg_t *m = (ipc_msg_t *)data;
+  return (ev == PROCESS_EVENT_MSG && m != NULL && m->refs > 0) ? m : NULL;
+}
+#endif
+
+#if IPC_CONF_POOL_OWNER
+/* Hand the message carried by an event to process p (or to nobody).
+ * Shared messages are left alone; their reference count frees them.
+ */
+static void event_msg_transfer(process_event_t ev, process_data_t data, struct process *p)
+{
+  if (ev != PROCESS_EVENT_MSG || data == NULL)
+    return;
+#if IPC_CONF_MSG_REFCOUNT
+  if (event_shared_msg(ev, data))
+    return;
+#endif
+  (void)ipc_owner_set(data, (p && p->state != PROCESS_STATE_NONE) ? p->pid : IPC_OWNER_NONE);
+}
+
+/* Smallest owner id that no registered process uses */
+static uint8_t process_alloc_pid(void)
+{
+  for (uint8_t id = 1; id < IPC_OWNER_UNTRACKED; id++)
+  {
+    struct process *pp = process_list;
+    while (pp != NULL && pp->pid != id)
+      pp = pp->next;
+    if (pp == NULL)
+      return id;
+  }
+  return IPC_OWNER_NONE; /* out of ids: blocks of this process are not tracked */
+}
+#endif
+
+#if IPC_CONF_POOL_OWNER || IPC_CONF_MSG_REFCOUNT
+/* Drop the events still queued for p (caller must ensure atomic), up to
+ * and including the first one that carries a shared message. Entries in
+ * the global queue are turned into PROCESS_EVENT_NONE, which do_event()
+ * skips. Returns that message, whose queue reference the caller releases
+ * outside the atomic section, or NULL when no event for p is left.
+ */
+static ipc_msg_t *drop_events_nolock(struct process *p)
+{
+  ipc_msg_t *m = NULL;
+  for (process_num_events_t i = event_tail; i != event_head && m == NULL; i = (i + 1) % PROCESS_CONF_EVENT_QUEUE_SIZE)
+  {
+    if (events[i].dest != p)
+      continue;
+#if IPC_CONF_MSG_REFCOUNT
+    m = event_shared_msg(events[i].ev, events[i].data);
+#endif
+    events[i].ev = PROCESS_EVENT_NONE;
+    events[i].data = NULL;
+  }
+#if PROCESS_CONF_PER_PROCESS_INBOX
+  struct process_event_entry e;
+  for (uint8_t lane = 0; lane < PROCESS_CONF_INBOX_LANES && m == NULL; lane++)
+  {
+    while (m == NULL && process_inbox_pop(p, lane, &e))
+    {
+#if IPC_CONF_MSG_REFCOUNT
+      m = event_shared_msg(e.ev, e.data);
+#endif
+    }
+  }
+#endif
+  return m;
+}
+#endif /* IPC_CONF_POOL_OWNER || IPC_CONF_MSG_REFCOUNT */
+
+#if IPC_CONF_TIMESTAMP
+/* Remember the post time of e for process_event_age() and record the
+ * latency of its delivery to p: the age of the message for
+ * PROCESS_EVENT_MSG, the time in the queue otherwise.
+ */
+static void event_account(const struct process_event_entry *e, struct process *p)
+{
+  event_stamp = e->stamp;
+  uint32_t age = (e->ev == PROCESS_EVENT_MSG && e->data != NULL)
+    ? ipc_msg_age((const ipc_msg_t *)e->data)
+    : clock_time() - e->stamp;
+  ipc_latency_record(e->src, p, age);
+}
+#endif
+
 /* Call a process's protothread and handle PT lifecycle correctly */
 static void call_process(struct process *p, process_event_t ev, process_data_t data)
 {
   if (!p)
     return;
 
+#if IPC_CONF_MSG_REFCOUNT
+  /* decided before the call: the thread may free a plain message */
+  bool shared = event_shared_msg(ev, data) != NULL;
+#endif
+
   p->state = PROCESS_STATE_RUNNING;
+  process_current = p;
+#if IPC_CONF_POOL_OWNER
+  ipc_owner_current = p->pid;
+#endif
   ptstate_t ret = p->thread(&p->pt, ev, data);
+  process_current = NULL;
+#if IPC_CONF_POOL_OWNER
+  ipc_owner_current = IPC_OWNER_NONE;
+#endif
 
   /* If still running (WAITING or YIELDED), mark called and return */
   if (PT_ISRUNNING(ret))
@@ -133,8 +325,18 @@ static void call_process(struct process *p, process_event_t ev, process_data_t d
     /* Arm the final state for the protothread */
     PT_FINAL(&p->pt);
 
-    /* Check for message leak *before* the process is removed */
-    if (ev == PROCESS_EVENT_MSG)
+    /* Check for message leak *before* the process is removed.
+     * Reference-counted messages are released by do_event() instead, and
+     * messages from tracked pools are reclaimed by process_exit().
+     */
+    if (ev == PROCESS_EVENT_MSG
+#if IPC_CONF_MSG_REFCOUNT
+        && !shared
+#endif
+#if IPC_CONF_POOL_OWNER
+        && ipc_owner_get(data) == IPC_OWNER_UNTRACKED
+#endif
+       )
     {
       // Post the message pointer to the logger for explicit freeing.
       // This prevents the fixed ipc_pool from being exhausted.
@@ -149,7 +351,15 @@ static void call_process(struct process *p, process_event_t ev, process_data_t d
     ptstate_t fret;
     do
     {
+      process_current = p;
+#if IPC_CONF_POOL_OWNER
+      ipc_owner_current = p->pid;
+#endif
       fret = p->thread(&p->pt, ev, data);
+      process_current = NULL;
+#if IPC_CONF_POOL_OWNER
+      ipc_owner_current = IPC_OWNER_NONE;
+#endif
       /* if the finalizer itself returns PT_ISERROR, post it as well */
       if (PT_ISERROR(fret) && process_error_logger)
       {
@@ -191,6 +401,9 @@ static int do_poll(void)
     if (pp->needspoll)
     {
       pp->needspoll = 0;
+#if IPC_CONF_TIMESTAMP
+      event_stamp = clock_time();
+#endif
       call_process(pp, PROCESS_EVENT_POLL, NULL);
       any = 1;
     }
@@ -202,54 +415,151 @@ static int do_poll(void)
 static int do_event(void)
 {
   struct process_event_entry e;
-  /* First service per-process inbox if enabled (low-latency directed msgs) */
+  /* First service per-process inbox if enabled (low-latency directed msgs),
+   * lane by lane, so urgent entries of any process go before the rest
+   */
 #if PROCESS_CONF_PER_PROCESS_INBOX
-  for (struct process *pp = process_list; pp != NULL; pp = pp->next)
+  for (uint8_t lane = 0; lane < PROCESS_CONF_INBOX_LANES; lane++)
   {
-    if (pp->inbox_head != pp->inbox_tail)
+    for (struct process *pp = process_list; pp != NULL; pp = pp->next)
     {
-      if (process_inbox_pop(pp, &e))
+      if (pp->inbox_head[lane] != pp->inbox_tail[lane])
       {
-        call_process(pp, e.ev, e.data);
-        return 1;
+        int popped;
+        CC_ATOMIC_RESTORE()
+        {
+          popped = process_inbox_pop(pp, lane, &e);
+        }
+        if (popped)
+        {
+#if IPC_CONF_POOL_OWNER
+          event_msg_transfer(e.ev, e.data, pp);
+#endif
+#if IPC_CONF_TIMESTAMP
+          event_account(&e, pp);
+#endif
+#if IPC_CONF_MSG_REFCOUNT
+          /* before the call: the receiver may free a plain message */
+          ipc_msg_t *m = event_shared_msg(e.ev, e.data);
+#endif
+          call_process(pp, e.ev, e.data);
+#if IPC_CONF_MSG_REFCOUNT
+          /* the reference travelling with the event belonged to this receiver */
+          if (m)
+            ipc_msg_release(m);
+#endif
+          return 1;
+        }
       }
     }
   }
 #endif
 
-  /* Otherwise pop one entry from global queue atomically */
+  /* Otherwise pop one entry from global queue atomically,
+   * skipping entries dropped by process_exit()
+   */
   CC_ATOMIC_RESTORE()
   {
-    if (!dequeue_event_nolock(&e))
+    do
     {
-      /* nothing */
-      e.dest = NULL;
-      e.ev = PROCESS_EVENT_NONE;
-      e.data = NULL;
-    }
+      if (!dequeue_event_nolock(&e))
+      {
+        /* nothing */
+        e.dest = NULL;
+        e.ev = PROCESS_EVENT_NONE;
+        e.data = NULL;
+        break;
+      }
+    } while (e.ev == PROCESS_EVENT_NONE);
   }
 
   if (e.ev == PROCESS_EVENT_NONE)
     return 0;
 
+#if IPC_CONF_MSG_REFCOUNT
+  ipc_msg_t *m = event_shared_msg(e.ev, e.data);
+#endif
+
   if (e.dest == NULL)
   {
+#if IPC_CONF_MSG_REFCOUNT
+    /* Pre-retain once per receiver, then drop the reference of the queue.
+     * Each receiver's reference is released after its call; references of
+     * receivers that exited before their turn are released at the end.
+     */
+    uint8_t retained = 0;
+    if (m)
+    {
+      for (struct process *pp = process_list; pp != NULL; pp = pp->next)
+      {
+        if (pp->state != PROCESS_STATE_NONE && ipc_msg_retain(m) == ERR_SUCCESS)
+          retained++;
+      }
+      ipc_msg_release(m);
+    }
+#endif
+#if IPC_CONF_POOL_OWNER
+    /* A plain message is handed from receiver to receiver, so it is
+     * reclaimed when the receiver exits while handling it. The hand-over
+     * stops once the previous receiver no longer holds it (freed or passed on).
+     */
+    uint8_t holder = IPC_OWNER_NONE;
+#endif
     /* Broadcast: call every registered process (no extra polls between calls) */
     for (struct process *pp = process_list; pp != NULL; pp = pp->next)
     {
       if (pp->state != PROCESS_STATE_NONE)
       {
+#if IPC_CONF_MSG_REFCOUNT
+        if (m)
+        {
+          if (retained == 0)
+            break;
+#if IPC_CONF_TIMESTAMP
+          event_account(&e, pp);
+#endif
+          call_process(pp, e.ev, e.data);
+          ipc_msg_release(m);
+          retained--;
+          continue;
+        }
+#endif
+#if IPC_CONF_POOL_OWNER
+        if (e.ev == PROCESS_EVENT_MSG && ipc_owner_get(e.data) == holder)
+        {
+          event_msg_transfer(e.ev, e.data, pp);
+          holder = pp->pid;
+        }
+#endif
+#if IPC_CONF_TIMESTAMP
+        event_account(&e, pp);
+#endif
         call_process(pp, e.ev, e.data);
       }
     }
+#if IPC_CONF_MSG_REFCOUNT
+    while (retained--)
+      ipc_msg_release(m);
+#endif
   }
   else
   {
     /* Directed: deliver to specific process if active */
     if (e.dest->state != PROCESS_STATE_NONE)
     {
+#if IPC_CONF_POOL_OWNER
+      event_msg_transfer(e.ev, e.data, e.dest);
+#endif
+#if IPC_CONF_TIMESTAMP
+      event_account(&e, e.dest);
+#endif
       call_process(e.dest, e.ev, e.data);
     }
+#if IPC_CONF_MSG_REFCOUNT
+    /* the reference of the queue belonged to the receiver */
+    if (m)
+      ipc_msg_release(m);
+#endif
   }
   return 1;
 }
@@ -275,9 +585,22 @@ void process_start(struct process *p)
   p->state = PROCESS_STATE_CALLED;
   p->needspoll = 0;
 
+#if PROCESS_CONF_COND
+  p->waiting_on = NULL;
+  p->cond_next = NULL;
+#endif
+
 #if PROCESS_CONF_PER_PROCESS_INBOX
-  p->inbox_head = 0;
-  p->inbox_tail = 0;
+  for (uint8_t lane = 0; lane < PROCESS_CONF_INBOX_LANES; lane++)
+  {
+    p->inbox_head[lane] = 0;
+    p->inbox_tail[lane] = 0;
+    p->inbox_overflow[lane] = 0;
+  }
+#endif
+
+#if IPC_CONF_POOL_OWNER
+  p->pid = process_alloc_pid();
 #endif
 
   /* insert by priority (lower numeric => higher priority) */
@@ -310,8 +633,54 @@ void process_exit(struct process *p)
     q = &((*q)->next);
   }
 
+#if PROCESS_CONF_COND
+  CC_ATOMIC_RESTORE()
+  {
+    if (p->waiting_on)
+      cond_unlink_nolock(p);
+  }
+#endif
+#if IPC_CONF_POOL_OWNER || IPC_CONF_MSG_REFCOUNT
+  /* its blocks are reclaimed below and its references given back, one
+   * message at a time: the release may free to a pool and run its signal
+   * callback, which must not happen with interrupts off */
+  ipc_msg_t *m;
+  do
+  {
+    CC_ATOMIC_RESTORE()
+    {
+      m = drop_events_nolock(p);
+    }
+#if IPC_CONF_MSG_REFCOUNT
+    if (m)
+      ipc_msg_release(m);
+#endif
+  } while (m);
+#endif
+
   p->state = PROCESS_STATE_NONE;
   p->next = NULL;
+
+#if IPC_CONF_RPC
+  /* nobody waits for the replies to its calls any more */
+  ipc_rpc_drop_caller(p);
+#endif
+#if IPC_CONF_BUS
+  ipc_bus_drop_process(p);
+#endif
+
+#if IPC_CONF_POOL_OWNER
+  /* free whatever the process still owns and tell the logger */
+  uint16_t n = ipc_owner_reclaim(p->pid);
+  if (n > 0 && process_error_logger)
+  {
+    uint8_t idx = (uint8_t)(reclaim_pool_idx++ % RECLAIM_INFO_POOL_SIZE);
+    reclaim_pool[idx].source = p;
+    reclaim_pool[idx].count = n;
+    (void)process_post(process_error_logger, PROCESS_EVENT_RECLAIM, &reclaim_pool[idx]);
+  }
+  p->pid = IPC_OWNER_NONE;
+#endif
 }
 
 void process_run(void)
@@ -321,41 +690,104 @@ void process_run(void)
   //  return;
   (void)do_poll(); // stop event starvation
   (void)do_event();
+#if IPC_CONF_RPC
+  ipc_rpc_expire(); // wake callers whose reply deadline passed
+#endif
 }
 
 /* Post event (atomic). If per-process inbox enabled and destination != NULL,
  * try to place in inbox first; otherwise fall back to global queue.
  */
 int process_post(struct process *p, process_event_t ev, process_data_t data)
+{
+  return process_post_lane(p, PROCESS_LANE_NORMAL, ev, data);
+}
+
+/* Queue an event posted by src (NULL from ISR) */
+static int post_event(struct process *p, uint8_t lane, process_event_t ev, process_data_t data, struct process *src)
 {
   int ok = 0;
+#if IPC_CONF_POOL_OWNER
+  /* an exited process would never receive it; the caller keeps the data */
+  if (p != NULL && p->state == PROCESS_STATE_NONE)
+    return 0;
+#endif
+  struct process_event_entry e;
+  e.dest = p;
+  e.ev = ev;
+  e.data = data;
+#if IPC_CONF_TIMESTAMP
+  e.stamp = clock_time();
+  e.src = src;
+#else
+  (void)src;
+#endif
   CC_ATOMIC_RESTORE()
   {
 #if PROCESS_CONF_PER_PROCESS_INBOX
     if (p != NULL)
     {
-      ok = process_inbox_push(p, ev, data);
-      if (!ok)
+      if (lane >= PROCESS_CONF_INBOX_LANES)
+        lane = PROCESS_CONF_INBOX_LANES - 1;
+      ok = process_inbox_push(p, lane, &e);
+      /* only the normal lane overflows into the global queue: do_event()
+       * drains it after all lanes, which would demote a priority entry */
+      if (!ok && lane == PROCESS_LANE_NORMAL)
       {
-        ok = enqueue_event_nolock(p, ev, data);
+        ok = enqueue_event_nolock(&e);
       }
     }
     else
     {
-      ok = enqueue_event_nolock(NULL, ev, data);
+      ok = enqueue_event_nolock(&e);
     }
 #else
-    ok = enqueue_event_nolock(p, ev, data);
+    (void)lane;
+    ok = enqueue_event_nolock(&e);
 #endif
   }
+#if IPC_CONF_POOL_OWNER
+  /* a directed message belongs to its receiver from now on */
+  if (ok)
+    event_msg_transfer(ev, data, p);
+#endif
   return ok;
 }
 
-/* process_post_from_isr: identical behavior for now */
+int process_post_lane(struct process *p, uint8_t lane, process_event_t ev, process_data_t data)
+{
+  /* the poster is the process whose protothread is running, if any */
+  struct process *src = (process_current != NULL && process_current->state == PROCESS_STATE_RUNNING)
+    ? process_current : NULL;
+  return post_event(p, lane, ev, data, src);
+}
+
+#if PROCESS_CONF_PER_PROCESS_INBOX
+uint16_t process_inbox_overflows(const struct process *p, uint8_t lane)
+{
+  if (!p || lane >= PROCESS_CONF_INBOX_LANES)
+    return 0;
+  uint16_t n;
+  CC_ATOMIC_RESTORE()
+  {
+    n = p->inbox_overflow[lane];
+  }
+  return n;
+}
+#endif
+
+/* process_post_from_isr: like process_post, accounted to source NULL */
 int process_post_from_isr(struct process *p, process_event_t ev, process_data_t data)
 {
-  return process_post(p, ev, data);
+  return post_event(p, PROCESS_LANE_NORMAL, ev, data, NULL);
+}
+
+#if IPC_CONF_TIMESTAMP
+uint32_t process_event_age(void)
+{
+  return clock_time() - event_stamp;
 }
+#endif
 
 void process_poll(struct process *p)
 {
@@ -377,3 +809,55 @@ void process_report_error(struct process *src, uint8_t code)
   /* best-effort post */
   (void)process_post(process_error_logger, PROCESS_EVENT_ERROR, &error_pool[idx]);
 }
+
+#if PROCESS_CONF_COND
+/* ---------------- Condition objects ---------------- */
+
+void process_cond_init(struct process_cond *cv)
+{
+  if (!cv)
+    return;
+  cv->waiters = NULL;
+}
+
+void process_cond_wait(struct process_cond *cv)
+{
+  struct process *p = process_current;
+  if (!cv || !p)
+    return;
+
+  CC_ATOMIC_RESTORE()
+  {
+    if (p->waiting_on != cv)
+    {
+      if (p->waiting_on)
+        cond_unlink_nolock(p);
+      p->waiting_on = cv;
+      p->cond_next = cv->waiters;
+      cv->waiters = p;
+    }
+  }
+}
+
+void process_cond_signal(void *cv)
+{
+  struct process_cond *c = (struct process_cond *)cv;
+  if (!c || !c->waiters)
+    return;
+
+  /* polling only sets flags, so the whole list is woken in one atomic section */
+  CC_ATOMIC_RESTORE()
+  {
+    struct process *p = c->waiters;
+    c->waiters = NULL;
+    while (p)
+    {
+      struct process *next = p->cond_next;
+      p->waiting_on = NULL;
+      p->cond_next = NULL;
+      process_poll(p);
+      p = next;
+    }
+  }
+}
+#endif
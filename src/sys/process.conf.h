@@ -21,5 +21,35 @@
 #define PROCESS_CONF_INBOX_POINTERS 0
 #endif
 
+/* Priority lanes per inbox (1..4). Lane 0 is the most urgent; do_event()
+ * drains lane 0 of all processes before it looks at lane 1, and so on.
+ * process_post() uses the last lane, process_post_lane() picks one.
+ */
+#ifndef PROCESS_CONF_INBOX_LANES
+#define PROCESS_CONF_INBOX_LANES 1
+#endif
+
+/* Depth of each lane (entries; one slot of each lane stays empty) */
+#ifndef PROCESS_CONF_INBOX_LANE0_SIZE
+#define PROCESS_CONF_INBOX_LANE0_SIZE PROCESS_CONF_INBOX_SIZE
+#endif
+
+#ifndef PROCESS_CONF_INBOX_LANE1_SIZE
+#define PROCESS_CONF_INBOX_LANE1_SIZE PROCESS_CONF_INBOX_SIZE
+#endif
+
+#ifndef PROCESS_CONF_INBOX_LANE2_SIZE
+#define PROCESS_CONF_INBOX_LANE2_SIZE PROCESS_CONF_INBOX_SIZE
+#endif
+
+#ifndef PROCESS_CONF_INBOX_LANE3_SIZE
+#define PROCESS_CONF_INBOX_LANE3_SIZE PROCESS_CONF_INBOX_SIZE
+#endif
+
+/* Condition objects (PT_WAIT_COND). Costs two pointers per process. */
+#ifndef PROCESS_CONF_COND
+#define PROCESS_CONF_COND 0
+#endif
+
 
 #endif
\ No newline at end of file
@@ -52,6 +52,12 @@ typedef enum {
 #define PROCESS_EVENT_MSG        60  /* intended to carry ipc_msg_t* */
 #define PROCESS_EVENT_MSG_LEAK   61  /* A process exited while holding this message data (ipc_msg_t*) */
 #define PROCESS_EVENT_PIPE_CTRL  62
+#define PROCESS_EVENT_RECLAIM    63  /* Pool blocks were reclaimed from an exited process (struct reclaim_info*) */
+
+/* Condition object: processes blocked in PT_WAIT_COND() until it is signalled */
+struct process_cond {
+    struct process *waiters;   /* processes waiting on this condition */
+};
 
 /* Error information structure */
 
@@ -60,6 +66,33 @@ struct error_info {
     uint8_t code;              /* raw ptstate_t error code (>= PT_ERROR) */
 };
 
+/* Reclaim information structure */
+
+struct reclaim_info {
+    struct process *source;    /* process that exited */
+    uint16_t count;            /* pool blocks freed on its behalf */
+};
+
+#if PROCESS_CONF_PER_PROCESS_INBOX
+#if PROCESS_CONF_INBOX_LANES < 1 || PROCESS_CONF_INBOX_LANES > 4
+#error "PROCESS_CONF_INBOX_LANES must be 1..4"
+#endif
+
+/* Entries of all inbox lanes together */
+#define PROCESS_INBOX_TOTAL (PROCESS_CONF_INBOX_LANE0_SIZE \
+  + (PROCESS_CONF_INBOX_LANES > 1 ? PROCESS_CONF_INBOX_LANE1_SIZE : 0) \
+  + (PROCESS_CONF_INBOX_LANES > 2 ? PROCESS_CONF_INBOX_LANE2_SIZE : 0) \
+  + (PROCESS_CONF_INBOX_LANES > 3 ? PROCESS_CONF_INBOX_LANE3_SIZE : 0))
+#endif
+
+/* Inbox lanes for process_post_lane() */
+#define PROCESS_LANE_URGENT  0
+#if PROCESS_CONF_PER_PROCESS_INBOX
+#define PROCESS_LANE_NORMAL  (PROCESS_CONF_INBOX_LANES - 1)
+#else
+#define PROCESS_LANE_NORMAL  0
+#endif
+
 /* -- process struct -------------------------------------------------- */
 
 struct process {
@@ -80,13 +113,29 @@ struct process {
 
 #if PROCESS_CONF_PER_PROCESS_INBOX
 #if PROCESS_CONF_INBOX_POINTERS
-    process_event_t inbox_ev[PROCESS_CONF_INBOX_SIZE];
-    process_data_t  inbox_data[PROCESS_CONF_INBOX_SIZE];
+    process_event_t inbox_ev[PROCESS_INBOX_TOTAL];
+    process_data_t  inbox_data[PROCESS_INBOX_TOTAL];
+#if IPC_CONF_TIMESTAMP
+    uint32_t inbox_stamp[PROCESS_INBOX_TOTAL];
+    struct process *inbox_src[PROCESS_INBOX_TOTAL];
+#endif
+#elif IPC_CONF_TIMESTAMP
+    struct { process_event_t ev; process_data_t data; uint32_t stamp; struct process *src; } inbox[PROCESS_INBOX_TOTAL];
 #else
-    struct { process_event_t ev; process_data_t data; } inbox[PROCESS_CONF_INBOX_SIZE];
+    struct { process_event_t ev; process_data_t data; } inbox[PROCESS_INBOX_TOTAL];
+#endif
+    uint8_t inbox_head[PROCESS_CONF_INBOX_LANES];      /* per lane, relative to the lane start */
+    uint8_t inbox_tail[PROCESS_CONF_INBOX_LANES];
+    uint16_t inbox_overflow[PROCESS_CONF_INBOX_LANES]; /* posts that did not fit their lane */
 #endif
-    uint8_t inbox_head;
-    uint8_t inbox_tail;
+
+#if PROCESS_CONF_COND
+    struct process_cond *waiting_on; /* condition this process is parked on */
+    struct process *cond_next;       /* next waiter on the same condition */
+#endif
+
+#if IPC_CONF_POOL_OWNER
+    uint8_t pid;                     /* owner id of the pool blocks of this process */
 #endif
 };
 
@@ -97,6 +146,37 @@ struct process {
     process_event_t ev, \
     process_data_t data)
 
+/* Initializers of the optional members, in declaration order */
+#if PT_CONF_LOCALS
+#define PROCESS_INIT_PT { 0, NULL }
+#else
+#define PROCESS_INIT_PT { 0 }
+#endif
+
+#if !PROCESS_CONF_PER_PROCESS_INBOX
+#define PROCESS_INIT_INBOX
+#elif PROCESS_CONF_INBOX_POINTERS && IPC_CONF_TIMESTAMP
+#define PROCESS_INIT_INBOX , { 0 }, { 0 }, { 0 }, { 0 }, { 0 }, { 0 }, { 0 }
+#elif PROCESS_CONF_INBOX_POINTERS
+#define PROCESS_INIT_INBOX , { 0 }, { 0 }, { 0 }, { 0 }, { 0 }
+#elif IPC_CONF_TIMESTAMP
+#define PROCESS_INIT_INBOX , { { 0, NULL, 0, NULL } }, { 0 }, { 0 }, { 0 }
+#else
+#define PROCESS_INIT_INBOX , { { 0, NULL } }, { 0 }, { 0 }, { 0 }
+#endif
+
+#if PROCESS_CONF_COND
+#define PROCESS_INIT_COND , NULL, NULL
+#else
+#define PROCESS_INIT_COND
+#endif
+
+#if IPC_CONF_POOL_OWNER
+#define PROCESS_INIT_PID , 0
+#else
+#define PROCESS_INIT_PID
+#endif
+
 #if defined(__AVR__)
 #include <avr/pgmspace.h>
 #define PROCESS(name, strname, priority) \
@@ -108,8 +188,11 @@ struct process {
     priority, \
     PROCESS_STATE_NONE, \
     0, 0, \
-    { 0 }, \
+    PROCESS_INIT_PT, \
     process_thread_##name \
+    PROCESS_INIT_INBOX \
+    PROCESS_INIT_COND \
+    PROCESS_INIT_PID \
   }
 #else
 #define PROCESS(name, strname, priority) \
@@ -121,8 +204,11 @@ struct process {
     priority, \
     PROCESS_STATE_NONE, \
     0, 0, \
-    { 0 }, \
+    PROCESS_INIT_PT, \
     process_thread_##name \
+    PROCESS_INIT_INBOX \
+    PROCESS_INIT_COND \
+    PROCESS_INIT_PID \
   }
 #endif
 
@@ -134,6 +220,10 @@ struct process {
 #define PROCESS_NAME_STRING(p) ((const char *)(p == NULL ? (const char*)"NULL" : (const char*)""))
 #endif
 
+/* The process whose protothread is running, NULL outside of process threads */
+extern struct process *process_current;
+#define PROCESS_CURRENT() process_current
+
 /* Protothread helpers */
 #define PROCESS_BEGIN()             PT_BEGIN(pt_process)
 #define PROCESS_END()               PT_END(pt_process)
@@ -151,26 +241,105 @@ void process_init(struct process *error_logger);
 /* Register and start a process (sends INIT) */
 void process_start(struct process *p);
 
-/* Stop and remove a process from scheduler */
+/* Stop and remove a process from scheduler. With IPC_CONF_POOL_OWNER or
+ * IPC_CONF_MSG_REFCOUNT the events still queued for it are dropped, and with
+ * IPC_CONF_POOL_OWNER every block of a tracked pool it owns is freed
+ * (reported to the logger as PROCESS_EVENT_RECLAIM).
+ */
 void process_exit(struct process *p);
 
 /* Game-loop scheduler: handle polls first if poll_requested, otherwise handle exactly one event */
 void process_run(void);
 
-/* Post event to global queue (atomic). Returns 1 on success, 0 if queue full.
- * p == NULL => broadcast.
+/* Post event to global queue (atomic). Returns 1 on success, 0 if queue full
+ * (or, with IPC_CONF_POOL_OWNER, p is not running). p == NULL => broadcast.
  * Safe to call from ISR (uses CC_ATOMIC_RESTORE()).
  */
 int process_post(struct process *p, process_event_t ev, process_data_t data);
 
-/* Alias for ISR explicitness (same behavior as process_post) */
+/* Post a directed event into a lane of p's inbox (PROCESS_LANE_URGENT for
+ * control messages). When the lane is full the overflow count of the lane
+ * is incremented; an event for PROCESS_LANE_NORMAL then goes to the global
+ * queue, an event for a higher lane is rejected (returns 0), since the
+ * global queue is only served after all lanes. Without
+ * PROCESS_CONF_PER_PROCESS_INBOX the lane is ignored. Same return values as
+ * process_post(); lanes above the last are clamped to it.
+ */
+int process_post_lane(struct process *p, uint8_t lane, process_event_t ev, process_data_t data);
+
+#if PROCESS_CONF_PER_PROCESS_INBOX
+/* Only defined with inboxes: without them nothing would be urgent */
+#define process_post_urgent(p, ev, data) process_post_lane((p), PROCESS_LANE_URGENT, (ev), (data))
+
+/* Posts to a lane of p that did not fit (queued globally or rejected) */
+uint16_t process_inbox_overflows(const struct process *p, uint8_t lane);
+#endif
+
+/* Alias for ISR explicitness (same behavior as process_post). With
+ * IPC_CONF_TIMESTAMP the event is accounted to the path from source NULL,
+ * not to the process that happened to be interrupted.
+ */
 int process_post_from_isr(struct process *p, process_event_t ev, process_data_t data);
 
+#if IPC_CONF_TIMESTAMP
+/* Time since the event the current process is handling was posted (for
+ * polls: since the poll was dispatched), in clock ticks. Delivered events
+ * are also recorded in the latency histograms of sys/ipc/latency.h.
+ */
+uint32_t process_event_age(void);
+#endif
+
 /* Request a poll for a process (sets needspoll and poll_requested) */
 void process_poll(struct process *p);
 
 /* Convenience: report error to configured logger (if any) */
 void process_report_error(struct process *src, uint8_t code);
 
+#if PROCESS_CONF_COND
+/* ------------------------------------------------------------------ */
+/* Condition objects                                                  */
+/* ------------------------------------------------------------------ */
+
+/* Initialize a condition object without waiters */
+void process_cond_init(struct process_cond *cv);
+
+/* Park the current process on cv until process_cond_signal(cv).
+ * A process waits on at most one condition; parking again is a no-op.
+ * Normally used through PT_WAIT_COND().
+ */
+void process_cond_wait(struct process_cond *cv);
+
+/* Wake all processes parked on cv by polling them. The argument is a
+ * struct process_cond*; the signature matches ipc_wake_cb_t, so this can be
+ * installed with ipc_pipe_set_signal() or ipc_pool_set_signal() (with
+ * IPC_CONF_SIGNAL) or as a serial TX callback. Safe to call from ISR.
+ */
+void process_cond_signal(void *cv);
+
+/* Block until predicate is true, parking the process on cv in between.
+ * The predicate is re-evaluated only when the process is called again,
+ * which normally happens when a source signals cv. The predicate is tested
+ * and the process parked in one atomic section, so a signal from an ISR
+ * can not get lost; keep the predicate short.
+ */
+#define PT_WAIT_COND(pt, cv, predicate) \
+  do { \
+    LC_SET((pt)->lc); \
+    { \
+      bool pt_cond_ready_ = true; \
+      CC_ATOMIC_RESTORE() { \
+        if (!(predicate)) { \
+          process_cond_wait(cv); \
+          pt_cond_ready_ = false; \
+        } \
+      } \
+      if (!pt_cond_ready_) \
+        return PT_WAITING; \
+    } \
+  } while(0)
+
+#define PROCESS_WAIT_COND(cv, c)    PT_WAIT_COND(pt_process, cv, c)
+#endif
+
 /* End of header */
 #endif /* PROCESS_H_ */
@@ -52,7 +52,9 @@ PROCESS_THREAD(error_logger_process, ev, data)
             print_P(PSTR(")\r\n"));
             serial0_flush();
         }
-        // 2. Handle Message Leaks (Patch from previous analysis)
+        // 2. Handle Message Leaks
+        // Only messages outside tracked pools are reported here; the kernel
+        // reclaims tracked blocks itself (see PROCESS_EVENT_RECLAIM).
         else if (ev == PROCESS_EVENT_MSG_LEAK)
         {
             ipc_msg_t *m = (ipc_msg_t *)data;
@@ -63,10 +65,6 @@ PROCESS_THREAD(error_logger_process, ev, data)
                 print_dec(m->type);
                 print_P(PSTR(" ArgC:"));
                 print_dec(m->argc);
-
-                // TODO: If you have a global pool, you can recover memory here:
-                // extern struct ipc_pool my_system_pool;
-                // ipc_msg_free_to_pool(&my_system_pool, m);
             }
             else
             {
@@ -75,6 +73,20 @@ PROCESS_THREAD(error_logger_process, ev, data)
             print_P(PSTR("\r\n"));
             serial0_flush();
         }
+#if IPC_CONF_POOL_OWNER
+        // 3. Report blocks the kernel reclaimed from an exited process
+        else if (ev == PROCESS_EVENT_RECLAIM)
+        {
+            struct reclaim_info *info = (struct reclaim_info *)data;
+
+            print_P(PSTR("[RECLAIM] Src:"));
+            print(PROCESS_NAME_STRING(info->source));
+            print_P(PSTR(" Blocks:"));
+            print_dec(info->count);
+            print_P(PSTR("\r\n"));
+            serial0_flush();
+        }
+#endif
     }
 
     PROCESS_END();
@@ -0,0 +1,29 @@
+// file: ./src/sys/pt.conf.h
+
+#ifndef __PT_CONF_H__
+#define __PT_CONF_H__
+
+// --------------------------------------------------------------------------
+// Configuration: Protothreads (override in protoduino-config.h)
+// --------------------------------------------------------------------------
+
+// 1: struct pt carries a pointer to a per-instance locals frame, which is
+//    used by the PT_LOCALS() facility in ./src/sys/pt/locals.h.
+//    This costs one pointer for every struct pt.
+// 0: struct pt only carries the local continuation (default).
+#ifndef PT_CONF_LOCALS
+#define PT_CONF_LOCALS 0
+#endif
+
+// Calls PT_ENDEACH() and pt_gen_close() make to finish the PT_FINALLY()
+// block of a child before they give up on it (see ./src/sys/pt/gen.h).
+#ifndef PT_CONF_FINAL_SPINS
+#define PT_CONF_FINAL_SPINS 16
+#endif
+
+// Size of the buffer in struct buf8_pt (see ./src/sys/pt/types.h).
+#ifndef PT_CONF_BUF8_SIZE
+#define PT_CONF_BUF8_SIZE 8
+#endif
+
+#endif
@@ -55,11 +55,16 @@
 #ifndef __PT_H__
 #define __PT_H__
 
+#include <stddef.h>
+#include <protoduino-config.h>
 #include <cc.h>
 #include "lc.h"
 
 struct pt {
   lc_t lc;
+#if PT_CONF_LOCALS
+  void *frame; // per-instance locals frame, see pt/locals.h
+#endif
 };
 
 typedef enum
@@ -146,12 +151,17 @@ typedef enum
  * way then using the protothread library, the protothread will stay in
  * the PT_FINALIZED state.
  *
+ * A protothread that is set to PT_FINAL() without a PT_FINALLY() block
+ * returns PT_FINALIZED, and an error raised with PT_RAISE() that is not
+ * catched is returned as the error state.
+ *
  * \param pt A pointer to the protothread control structure.
  *
  * \hideinitializer
  */
 #define PT_END(pt) \
   LC_END((pt)->lc, return PT_FINALIZED); \
+  return (ptstate_t)LC_ERRDEC((pt)->lc, PT_ERROR); \
   }
 
 /** @} */
@@ -550,7 +560,22 @@ typedef enum
   } while(0)
 
 /**
- * Spawn a protothread and wait until it yields.
+ * Spawn a protothread and iterate over the values it yields.
+ *
+ * The statement following this macro runs each time the child
+ * protothread returns PT_YIELDED. When the child returns PT_WAITING,
+ * the parent protothread waits one cycle. The iteration ends when the
+ * child exits, ends or fails, or when the statement leaves the loop
+ * with break.
+ *
+ * In both cases PT_ENDEACH() sets the child to PT_FINAL() and runs it
+ * until it returns PT_FINALIZED, so its PT_FINALLY() block can release
+ * what it holds. The finally block runs synchronously, like the
+ * finalization of a process, and must not block: after
+ * PT_CONF_FINAL_SPINS calls that return PT_WAITING or PT_YIELDED the
+ * child is abandoned and PT_ERROR is raised, instead of hanging the
+ * scheduler. An error of the child, or else an error raised in its
+ * finally block, is raised in the parent afterwards.
  *
  * This macro can be nested.
  *
@@ -565,10 +590,24 @@ typedef enum
 #define PT_FOREACH(pt, child, thread) \
   do { \
     PT_INIT((child)); \
-    while(PT_SCHEDULE(thread)) { \
-      if (PT_ERROR_STATE == PT_WAITING) \
-        PT_WAIT_ONE(pt); \
-      else if (PT_ERROR_STATE == PT_YIELDED) \
+    for (;; (child)->lc != LC_ERRENC(255) \
+          ? (PT_ERROR_STATE = PT_YIELDED, LC_FINAL((child)->lc)) : 0) { \
+      if ((child)->lc == LC_ERRENC(255)) { \
+        if (PT_ERROR_STATE != PT_FINALIZED) { \
+          uint8_t pt_spins_ = PT_CONF_FINAL_SPINS; \
+          ptstate_t pt_final_; \
+          while (PT_ISRUNNING(pt_final_ = (thread)) && --pt_spins_ > 0); \
+          if (PT_ISRUNNING(pt_final_)) \
+            PT_ERROR_STATE = PT_ERROR; \
+          else if (PT_ISERROR(pt_final_) && !PT_ISERROR(PT_ERROR_STATE)) \
+            PT_ERROR_STATE = pt_final_; \
+        } \
+        break; \
+      } \
+      while(PT_SCHEDULE(thread) || (LC_FINAL((child)->lc), 0)) { \
+        if (PT_ERROR_STATE == PT_WAITING) \
+          PT_WAIT_ONE(pt); \
+        else if (PT_ERROR_STATE == PT_YIELDED) \
 
 
 /**
@@ -576,20 +615,18 @@ typedef enum
  *
  * This macro is used for declaring that a foreach loop ends.
  * It must always be used together with a matching PT_FOREACH()
- * macro.
- *
- * \todo this is a nonsensical way to finalize it. rewrite.
+ * macro. It finalizes the child protothread and raises its error,
+ * if any, in the parent protothread.
  *
  * \param pt A pointer to the protothread control structure.
  *
  * \hideinitializer
  */
 #define PT_ENDEACH(pt) \
+      } \
     } \
-    if (PT_ERROR_STATE != PT_FINALIZED) { \
-      if (PT_ERROR_STATE >= PT_ERROR) \
-        PT_RAISE(pt, PT_ERROR_STATE); \
-    } \
+    PT_ONERROR(PT_ERROR_STATE) \
+      PT_RAISE(pt, PT_ERROR_STATE); \
   } while(0)
 
 /** @} */
@@ -0,0 +1,180 @@
+// file: ./src/sys/pt/gen.c
+
+#include <string.h>
+
+#include "gen.h"
+
+void pt_gen_init(struct pt_gen *g, pt_gen_fn next, struct pt_gen *src,
+  void *value, uint8_t size)
+{
+  PT_INIT(g);
+  g->next = next;
+  g->src = src;
+  g->value = value;
+  g->size = size;
+  g->state = PT_FINALIZED;
+}
+
+void pt_gen_close(struct pt_gen *g)
+{
+  if (g == NULL || g->state == PT_FINALIZED)
+    return;
+
+  PT_FINAL(g);
+  for (uint8_t n = PT_CONF_FINAL_SPINS; n > 0; --n) {
+    if (!PT_ISRUNNING(PT_GEN_NEXT(g)))
+      break;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+static ptstate_t read8_next(struct pt_gen *self)
+{
+  struct pt_gen_read8 *g = (struct pt_gen_read8 *)self;
+  int_fast16_t c;
+
+  PT_BEGIN(self);
+
+  for (;;) {
+    PT_WAIT_UNTIL(self, (c = g->read()) >= 0);
+    g->value = (uint8_t)c;
+    PT_YIELD(self);
+  }
+
+  PT_END(self);
+}
+
+void pt_gen_read8_init(struct pt_gen_read8 *g, int_fast16_t (*read)(void))
+{
+  pt_gen_init(&g->gen, read8_next, NULL, &g->value, sizeof(g->value));
+  g->read = read;
+}
+
+/*---------------------------------------------------------------------------*/
+static ptstate_t map_next(struct pt_gen *self)
+{
+  struct pt_gen_map *g = (struct pt_gen_map *)self;
+
+  PT_BEGIN(self);
+
+  PT_GEN_FOREACH(self)
+  {
+    if (g->fn(self->value, self->src->value, g->ctx))
+      PT_YIELD(self);
+  }
+  PT_ENDEACH(self);
+
+  PT_FINALLY(self)
+
+  pt_gen_close(self->src);
+
+  PT_END(self);
+}
+
+void pt_gen_map_init(struct pt_gen_map *g, struct pt_gen *src,
+  pt_gen_map_fn fn, void *ctx, void *value, uint8_t size)
+{
+  pt_gen_init(&g->gen, map_next, src, value, size);
+  g->fn = fn;
+  g->ctx = ctx;
+}
+
+/*---------------------------------------------------------------------------*/
+static ptstate_t filter_next(struct pt_gen *self)
+{
+  struct pt_gen_filter *g = (struct pt_gen_filter *)self;
+
+  PT_BEGIN(self);
+
+  PT_GEN_FOREACH(self)
+  {
+    if (g->fn(self->src->value, g->ctx))
+      PT_YIELD(self);
+  }
+  PT_ENDEACH(self);
+
+  PT_FINALLY(self)
+
+  pt_gen_close(self->src);
+
+  PT_END(self);
+}
+
+void pt_gen_filter_init(struct pt_gen_filter *g, struct pt_gen *src,
+  pt_gen_pred_fn fn, void *ctx)
+{
+  /* the value of the source is passed on as is */
+  pt_gen_init(&g->gen, filter_next, src, src->value, src->size);
+  g->fn = fn;
+  g->ctx = ctx;
+}
+
+/*---------------------------------------------------------------------------*/
+static ptstate_t take_next(struct pt_gen *self)
+{
+  struct pt_gen_take *g = (struct pt_gen_take *)self;
+
+  PT_BEGIN(self);
+
+  g->count = 0;
+  if (g->n == 0)
+    PT_EXIT(self);
+
+  PT_GEN_FOREACH(self)
+  {
+    PT_YIELD(self);
+    if (++g->count >= g->n)
+      break; /* finalizes the source */
+  }
+  PT_ENDEACH(self);
+
+  PT_FINALLY(self)
+
+  pt_gen_close(self->src);
+
+  PT_END(self);
+}
+
+void pt_gen_take_init(struct pt_gen_take *g, struct pt_gen *src, uint16_t n)
+{
+  pt_gen_init(&g->gen, take_next, src, src->value, src->size);
+  g->n = n;
+  g->count = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+static ptstate_t batch_next(struct pt_gen *self)
+{
+  struct pt_gen_batch *g = (struct pt_gen_batch *)self;
+  const uint8_t size = self->src->size;
+
+  PT_BEGIN(self);
+
+  g->count = 0;
+  PT_GEN_FOREACH(self)
+  {
+    memcpy((uint8_t *)self->value + g->count * size, self->src->value, size);
+    if (++g->count == g->n) {
+      PT_YIELD(self);
+      g->count = 0;
+    }
+  }
+  PT_ENDEACH(self);
+
+  if (g->count > 0)
+    PT_YIELD(self);
+
+  PT_FINALLY(self)
+
+  pt_gen_close(self->src);
+
+  PT_END(self);
+}
+
+void pt_gen_batch_init(struct pt_gen_batch *g, struct pt_gen *src,
+  void *buf, uint8_t n)
+{
+  pt_gen_init(&g->gen, batch_next, src, buf, (uint8_t)(src->size * n));
+  g->n = n;
+  g->count = 0;
+}
@@ -0,0 +1,260 @@
+// file: ./src/sys/pt/gen.h
+
+/**
+ * \addtogroup pt
+ * @{
+ */
+
+/**
+ * \defgroup ptgen Generator pipelines
+ * @{
+ *
+ * A generator is an iterator protothread with a common header, so it
+ * can be used as the source of another generator. Every generator
+ * pulls values from its upstream generator with PT_FOREACH() and
+ * yields its own values with PT_YIELD(). Chaining generators gives a
+ * pipeline without any buffers between the stages: a value is passed
+ * on as soon as it was produced, by reading it from the value of the
+ * upstream generator.
+ *
+ * The value of a generator has a declared type. It lives in the
+ * structure of the stage and the header points to it, so a stage
+ * reads the value of its source with PT_GEN_VALUE().
+ *
+ * This module provides the following stages:
+ *
+ * - pt_gen_read8 reads bytes from a function like serial0_read8().
+ * - pt_gen_map converts each value, and may drop values.
+ * - pt_gen_filter passes the values for which a predicate holds.
+ * - pt_gen_take passes the first n values and then stops its source.
+ * - pt_gen_batch groups n values into a buffer.
+ *
+ * When a generator ends, or the consumer leaves PT_FOREACH() with
+ * break, the generator is finalized and finalizes its source in turn.
+ *
+ * Stages must be initialized from the source to the sink, because
+ * filter, take and batch take over the value of their source.
+ *
+ \code
+#include <sys/pt/gen.h>
+#include <lib/utf/utf8-gen.h>
+
+static struct pt_gen_read8 bytes;
+static struct utf8_gen_decode runes;
+static struct vt_gen_keys keys;
+
+PT_THREAD(terminal(struct pt *pt))
+{
+  PT_BEGIN(pt);
+
+  pt_gen_read8_init(&bytes, serial0_read8);
+  utf8_gen_decode_init(&runes, &bytes.gen);
+  vt_gen_keys_init(&keys, &runes.gen);
+
+  PT_FOREACH(pt, &keys.gen, PT_GEN_NEXT(&keys.gen))
+  {
+    if (keys.value == KEY_ESCAPE)
+      break;
+    handle_key(keys.value);
+  }
+  PT_ENDEACH(pt);
+
+  PT_END(pt);
+}
+ \endcode
+ *
+ */
+
+/**
+ * \file
+ * Typed generators that can be chained into pipelines.
+ * \author
+ * Joham https://github.com/jklarenbeek
+ */
+
+#ifndef __PT_GEN_H__
+#define __PT_GEN_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../pt.h"
+
+struct pt_gen;
+
+/**
+ * Prototype of a generator protothread.
+ *
+ * \param self The header of the generator.
+ */
+typedef ptstate_t (*pt_gen_fn)(struct pt_gen *self);
+
+/**
+ * The header of every generator.
+ *
+ * It must be the first member of a generator structure.
+ */
+struct pt_gen {
+  lc_t lc;
+  pt_gen_fn next;       // generator protothread
+  struct pt_gen *src;   // upstream generator, or NULL for a source
+  void *value;          // points to the value yielded by the generator
+  uint8_t size;         // size of the value in bytes
+  ptstate_t state;      // last state returned by next
+};
+
+/**
+ * Initialize the header of a generator.
+ *
+ * \param g A pointer to the generator header.
+ * \param next The generator protothread.
+ * \param src The upstream generator, or NULL.
+ * \param value A pointer to the value of the generator.
+ * \param size The size of the value.
+ */
+CC_EXTERN void pt_gen_init(struct pt_gen *g, pt_gen_fn next, struct pt_gen *src,
+  void *value, uint8_t size);
+
+/**
+ * Finalize a generator that was left while it was still running.
+ *
+ * This runs the finally blocks of the generator and, through them, of
+ * all its sources. It does nothing when the generator was finalized
+ * already or never ran. A finally block that still returns PT_WAITING or
+ * PT_YIELDED after PT_CONF_FINAL_SPINS calls is abandoned; g->state then
+ * holds that state.
+ *
+ * \param g A pointer to the generator header.
+ */
+CC_EXTERN void pt_gen_close(struct pt_gen *g);
+
+/**
+ * Schedule a generator once.
+ *
+ * Use this as the thread argument of PT_FOREACH().
+ *
+ * \param g A pointer to the generator header.
+ *
+ * \hideinitializer
+ */
+#define PT_GEN_NEXT(g) ((g)->state = (g)->next(g))
+
+/**
+ * Access the value of a generator as the given type.
+ *
+ * \param g A pointer to the generator header.
+ * \param type The declared type of the value.
+ *
+ * \hideinitializer
+ */
+#define PT_GEN_VALUE(g, type) (*(type *)(g)->value)
+
+/**
+ * Iterate over the values of the source of a generator.
+ *
+ * Use this inside a generator protothread together with PT_ENDEACH().
+ *
+ * \param self A pointer to the header of the generator.
+ *
+ * \hideinitializer
+ */
+#define PT_GEN_FOREACH(self) \
+  PT_FOREACH(self, (self)->src, PT_GEN_NEXT((self)->src))
+
+/*---------------------------------------------------------------------------*/
+
+/** A source that reads bytes with a function like serial0_read8() */
+struct pt_gen_read8 {
+  struct pt_gen gen;
+  int_fast16_t (*read)(void); // returns a byte, or a negative value when empty
+  uint8_t value;
+};
+
+CC_EXTERN void pt_gen_read8_init(struct pt_gen_read8 *g, int_fast16_t (*read)(void));
+
+/**
+ * Conversion function of a map stage.
+ *
+ * \param out A pointer to the value of the map stage.
+ * \param in A pointer to the value of the source.
+ * \param ctx The context given with pt_gen_map_init().
+ *
+ * \return true to yield the converted value, false to drop it.
+ */
+typedef bool (*pt_gen_map_fn)(void *out, const void *in, void *ctx);
+
+/** A stage that converts the values of its source */
+struct pt_gen_map {
+  struct pt_gen gen;
+  pt_gen_map_fn fn;
+  void *ctx;
+};
+
+/**
+ * Initialize a map stage.
+ *
+ * \param g A pointer to the stage.
+ * \param src The source of the stage.
+ * \param fn The conversion function.
+ * \param ctx A context passed to the conversion function.
+ * \param value A pointer to the value of the stage.
+ * \param size The size of the value.
+ */
+CC_EXTERN void pt_gen_map_init(struct pt_gen_map *g, struct pt_gen *src,
+  pt_gen_map_fn fn, void *ctx, void *value, uint8_t size);
+
+/**
+ * Predicate of a filter stage.
+ *
+ * \param in A pointer to the value of the source.
+ * \param ctx The context given with pt_gen_filter_init().
+ */
+typedef bool (*pt_gen_pred_fn)(const void *in, void *ctx);
+
+/** A stage that passes the values of its source for which a predicate holds */
+struct pt_gen_filter {
+  struct pt_gen gen;
+  pt_gen_pred_fn fn;
+  void *ctx;
+};
+
+CC_EXTERN void pt_gen_filter_init(struct pt_gen_filter *g, struct pt_gen *src,
+  pt_gen_pred_fn fn, void *ctx);
+
+/** A stage that passes the first n values of its source */
+struct pt_gen_take {
+  struct pt_gen gen;
+  uint16_t n;
+  uint16_t count;
+};
+
+CC_EXTERN void pt_gen_take_init(struct pt_gen_take *g, struct pt_gen *src, uint16_t n);
+
+/**
+ * A stage that groups the values of its source.
+ *
+ * It yields each time n values were collected in the buffer, and
+ * once more with the remaining values when the source ends. The count
+ * member holds the number of values in the buffer.
+ */
+struct pt_gen_batch {
+  struct pt_gen gen;
+  uint8_t n;
+  uint8_t count;
+};
+
+/**
+ * Initialize a batch stage.
+ *
+ * \param g A pointer to the stage.
+ * \param src The source of the stage.
+ * \param buf A buffer for n values of the source.
+ * \param n The number of values in a batch.
+ */
+CC_EXTERN void pt_gen_batch_init(struct pt_gen_batch *g, struct pt_gen *src,
+  void *buf, uint8_t n);
+
+#endif /* __PT_GEN_H__ */
+
+/** @} */
+/** @} */
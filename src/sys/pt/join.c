@@ -0,0 +1,89 @@
+// file: ./src/sys/pt/join.c
+
+#include "join.h"
+
+void pt_join_init(struct pt_child *c, uint8_t n)
+{
+  for (uint8_t i = 0; i < n; ++i) {
+    PT_INIT(&c[i].pt);
+    c[i].state = PT_WAITING;
+    c[i].phase = PT_CHILD_IDLE;
+  }
+}
+
+void pt_join_cancel(struct pt_child *c, uint8_t n)
+{
+  for (uint8_t i = 0; i < n; ++i) {
+    if (c[i].phase == PT_CHILD_IDLE) {
+      /* never ran, so there is nothing to finalize */
+      c[i].phase = PT_CHILD_DONE;
+      c[i].state = ERR_PROC_CANCELLED;
+    }
+    else if (c[i].phase == PT_CHILD_RUNNING) {
+      PT_FINAL(&c[i].pt);
+      c[i].phase = PT_CHILD_FINALIZING;
+      c[i].state = ERR_PROC_CANCELLED;
+    }
+  }
+}
+
+ptstate_t pt_join_schedule(struct pt_child *c, uint8_t n, bool any)
+{
+  bool pending = false;
+
+  for (uint8_t i = 0; i < n; ++i) {
+    struct pt_child *ch = &c[i];
+
+    if (ch->phase == PT_CHILD_IDLE || ch->phase == PT_CHILD_RUNNING) {
+      ptstate_t s = ch->thread(&ch->pt, ch->arg);
+      ch->state = s;
+      if (PT_ISRUNNING(s)) {
+        ch->phase = PT_CHILD_RUNNING;
+        pending = true;
+        continue;
+      }
+
+      if (s == PT_FINALIZED) {
+        ch->phase = PT_CHILD_DONE;
+      }
+      else {
+        /* exited, ended or failed: arm its finally block */
+        PT_FINAL(&ch->pt);
+        ch->phase = PT_CHILD_FINALIZING;
+      }
+
+      /* the siblings that come after us are cancelled before they run */
+      if (any || PT_ISERROR(s))
+        pt_join_cancel(c, n);
+    }
+
+    if (ch->phase == PT_CHILD_FINALIZING) {
+      /* finally blocks may block, so this can take several rounds; any
+       * other state (PT_FINALIZED, or an error raised in the finally
+       * block) means the child will not run again */
+      if (PT_ISRUNNING(ch->thread(&ch->pt, ch->arg)))
+        pending = true;
+      else
+        ch->phase = PT_CHILD_DONE;
+    }
+  }
+
+  if (pending)
+    return PT_WAITING;
+
+  /* all children are finalized: report the first genuine error */
+  for (uint8_t i = 0; i < n; ++i) {
+    if (c[i].state != ERR_PROC_CANCELLED && PT_ISERROR(c[i].state))
+      return c[i].state;
+  }
+  return PT_ENDED;
+}
+
+int8_t pt_join_winner(const struct pt_child *c, uint8_t n)
+{
+  for (uint8_t i = 0; i < n; ++i) {
+    if (c[i].state != ERR_PROC_CANCELLED && !PT_ISRUNNING(c[i].state))
+      return (int8_t)i;
+  }
+  return -1;
+}
@@ -0,0 +1,208 @@
+// file: ./src/sys/pt/join.h
+
+/**
+ * \addtogroup pt
+ * @{
+ */
+
+/**
+ * \defgroup ptjoin Structured concurrency for protothreads
+ * @{
+ *
+ * PT_SPAWN() runs a single child protothread. Combining several
+ * children with an expression like producer(&a) & consumer(&b) runs
+ * them side by side, but it can not stop one child when another one
+ * finishes or fails.
+ *
+ * This module runs an array of child protothreads as a group:
+ *
+ * - PT_JOIN_ALL() blocks until every child has completed. If a child
+ *   fails with an error, all siblings that are still running are
+ *   cancelled and the error is raised in the parent.
+ * - PT_JOIN_ANY() blocks until the first child completes (for example
+ *   a read racing a timeout) and cancels all other children.
+ *
+ * Cancelled children are driven through PT_FINAL() so their
+ * PT_FINALLY() blocks run, and their state is set to
+ * ERR_PROC_CANCELLED. Finally blocks may block; the join waits until
+ * every child has reached PT_FINALIZED. A child that never ran is not
+ * finalized.
+ *
+ * Children must end with PT_END(), which returns PT_FINALIZED for a
+ * child that is set to PT_FINAL() without a PT_FINALLY() block. A
+ * finally block that raises an error also completes the child.
+ *
+ \code
+#include <sys/pt/join.h>
+
+static ptstate_t reader(struct pt *pt, void *arg);
+static ptstate_t timeout(struct pt *pt, void *arg);
+
+PT_THREAD(request(struct pt *pt))
+{
+  static struct pt_child race[] = {
+    PT_CHILD(reader, &uart_pipe),
+    PT_CHILD(timeout, (void*)500),
+  };
+
+  PT_BEGIN(pt);
+
+  PT_JOIN_ANY(pt, race, CC_NELEM(race));
+  if (pt_join_winner(race, CC_NELEM(race)) == 1)
+    PT_RAISE(pt, ERR_INIT_TIMEOUT);
+
+  PT_END(pt);
+}
+ \endcode
+ *
+ */
+
+/**
+ * \file
+ * Join and race groups of child protothreads.
+ * \author
+ * Joham https://github.com/jklarenbeek
+ */
+
+#ifndef __PT_JOIN_H__
+#define __PT_JOIN_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../pt.h"
+#include "../errors.h"
+
+/**
+ * Prototype of a child protothread that can be joined.
+ *
+ * \param pt A pointer to the child's protothread control structure.
+ * \param arg The argument given with PT_CHILD().
+ */
+typedef ptstate_t (*pt_child_fn)(struct pt *pt, void *arg);
+
+/** Lifecycle phase of a child in a join group (see struct pt_child) */
+enum {
+  PT_CHILD_IDLE       = 0, // not scheduled yet
+  PT_CHILD_RUNNING    = 1, // returned PT_WAITING or PT_YIELDED
+  PT_CHILD_FINALIZING = 2, // completed or cancelled, running its finally block
+  PT_CHILD_DONE       = 3  // reached PT_FINALIZED
+};
+
+/**
+ * A child protothread in a join group.
+ *
+ * The state member holds the last state returned by the child while
+ * it runs, and its outcome once it completed: PT_EXITED, PT_ENDED,
+ * PT_FINALIZED, an error code, or ERR_PROC_CANCELLED when it was
+ * cancelled by the join.
+ */
+struct pt_child {
+  struct pt pt;
+  pt_child_fn thread;
+  void *arg;
+  ptstate_t state;
+  uint8_t phase;
+};
+
+/**
+ * Static initializer for a struct pt_child.
+ *
+ * \param fn The child protothread function (see pt_child_fn).
+ * \param a The argument passed to the child protothread.
+ *
+ * \hideinitializer
+ */
+#define PT_CHILD(fn, a) { { 0 }, (fn), (void*)(a), PT_WAITING, PT_CHILD_IDLE }
+
+/**
+ * Reset all children of a join group to their initial state.
+ *
+ * \param c The array of children.
+ * \param n The number of children in the array.
+ */
+CC_EXTERN void pt_join_init(struct pt_child *c, uint8_t n);
+
+/**
+ * Schedule all children of a join group once.
+ *
+ * \param c The array of children.
+ * \param n The number of children in the array.
+ * \param any When true, the first child that completes cancels all others.
+ *            When false, only a child that fails cancels the others.
+ *
+ * \return PT_WAITING while any child is running or finalizing. Once all
+ *         children reached PT_FINALIZED, the first error of a child that
+ *         was not cancelled, or PT_ENDED when no such error occurred.
+ */
+CC_EXTERN ptstate_t pt_join_schedule(struct pt_child *c, uint8_t n, bool any);
+
+/**
+ * Cancel all children of a join group that are still running.
+ *
+ * Use this when the parent itself is cancelled while it waits in a join.
+ * The cancelled children still need pt_join_schedule() to run their
+ * finally blocks.
+ *
+ * \param c The array of children.
+ * \param n The number of children in the array.
+ */
+CC_EXTERN void pt_join_cancel(struct pt_child *c, uint8_t n);
+
+/**
+ * Get the index of the child that completed a PT_JOIN_ANY().
+ *
+ * \param c The array of children.
+ * \param n The number of children in the array.
+ *
+ * \return The index of the first child that was not cancelled, or -1.
+ */
+CC_EXTERN int8_t pt_join_winner(const struct pt_child *c, uint8_t n);
+
+/**
+ * Run a group of child protothreads and wait until all completed.
+ *
+ * The children are re-initialized first. If a child fails, the running
+ * siblings are cancelled and, once every child is finalized, the error
+ * is raised in the parent protothread.
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param children An array of struct pt_child.
+ * \param n The number of children in the array.
+ *
+ * \hideinitializer
+ */
+#define PT_JOIN_ALL(pt, children, n) \
+  do { \
+    pt_join_init((children), (n)); \
+    PT_WAIT_WHILE(pt, PT_SCHEDULE(pt_join_schedule((children), (n), false))); \
+    PT_ONERROR(PT_ERROR_STATE) \
+      PT_RAISE(pt, PT_ERROR_STATE); \
+  } while(0)
+
+/**
+ * Run a group of child protothreads until the first one completes.
+ *
+ * The children are re-initialized first. As soon as one child exits,
+ * ends or fails, all other children are cancelled. Once every child is
+ * finalized, an error of the first child is raised in the parent
+ * protothread. Use pt_join_winner() to find out which child completed.
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param children An array of struct pt_child.
+ * \param n The number of children in the array.
+ *
+ * \hideinitializer
+ */
+#define PT_JOIN_ANY(pt, children, n) \
+  do { \
+    pt_join_init((children), (n)); \
+    PT_WAIT_WHILE(pt, PT_SCHEDULE(pt_join_schedule((children), (n), true))); \
+    PT_ONERROR(PT_ERROR_STATE) \
+      PT_RAISE(pt, PT_ERROR_STATE); \
+  } while(0)
+
+#endif /* __PT_JOIN_H__ */
+
+/** @} */
+/** @} */
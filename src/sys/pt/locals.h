@@ -0,0 +1,210 @@
+// file: ./src/sys/pt/locals.h
+
+/**
+ * \addtogroup pt
+ * @{
+ */
+
+/**
+ * \defgroup ptlocals Protothread locals frames
+ * @{
+ *
+ * Protothreads do not preserve the stack, so any variable that must
+ * survive a blocking wait is traditionally declared <i>static</i>.
+ * That makes the protothread body non-reentrant (two instances share
+ * the same variables) and the statics occupy RAM for as long as the
+ * program runs, even when the protothread is idle.
+ *
+ * This module moves those variables into a <i>locals frame</i> that is
+ * attached to the struct pt of each running instance. The frame is
+ * taken from a fixed-block ipc_pool when the protothread starts and is
+ * given back to the pool when the protothread reaches PT_FINALIZED.
+ * RAM usage therefore scales with the number of live protothreads, not
+ * with the number of protothread functions.
+ *
+ \code
+#include <sys/pt/locals.h>
+
+PT_LOCALS(producer) {
+  int produced;
+};
+
+static uint8_t frames_buf[sizeof(PT_LOCALS(producer)) * 2];
+static struct ipc_pool frames;
+PT_LOCALS_CHECK(producer, sizeof(PT_LOCALS(producer)));
+
+PT_THREAD(producer(struct pt *pt))
+{
+  PT_BEGIN_LOCALS(pt, producer, &frames);
+
+  for(PT_FRAME(pt, producer)->produced = 0;
+      PT_FRAME(pt, producer)->produced < NUM_ITEMS;
+      ++PT_FRAME(pt, producer)->produced) {
+    PT_SEM_WAIT(pt, &full);
+    add_to_buffer(produce_item());
+    PT_SEM_SIGNAL(pt, &empty);
+  }
+
+  PT_END_LOCALS(pt, &frames);
+}
+
+void setup()
+{
+  ipc_pool_init(&frames, frames_buf, sizeof(PT_LOCALS(producer)), 2);
+}
+ \endcode
+ *
+ * \note The pool block size must be at least sizeof(PT_LOCALS(name)).
+ *       PT_LOCALS_CHECK() verifies that at compile time. Blocks are never
+ *       smaller than a pointer (see ipc_pool_init()), so size the pool
+ *       buffer accordingly for very small frames.
+ *
+ * \note A process that is removed with process_exit() without ever
+ *       reaching PT_END_LOCALS() must release its frame manually with
+ *       PT_FREE_LOCALS(). PT_INIT_LOCALS() detaches the frame, so release
+ *       it before re-initialising an abandoned instance.
+ *
+ */
+
+/**
+ * \file
+ * Per-instance locals frames for protothreads.
+ * \author
+ * Joham https://github.com/jklarenbeek
+ */
+
+#ifndef __PT_LOCALS_H__
+#define __PT_LOCALS_H__
+
+#include <string.h>
+
+#include "../pt.h"
+#include "../ipc.h"
+
+#if !PT_CONF_LOCALS
+#error "pt/locals.h requires PT_CONF_LOCALS to be enabled in pt.conf.h"
+#endif
+
+/**
+ * Declare the locals frame of a protothread.
+ *
+ * This macro expands to the struct type holding the locals of the
+ * protothread named name. Follow it with the member list to define the
+ * frame, or use it as a type (for example with sizeof()).
+ *
+ * \param name The name of the protothread (any unique identifier).
+ *
+ * \hideinitializer
+ */
+#define PT_LOCALS(name) struct CC_CONCAT2(name, _pt_locals)
+
+/**
+ * Access the locals frame of a protothread instance.
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param name The name used with PT_LOCALS().
+ *
+ * \return A typed pointer to the frame, or NULL when no frame is attached.
+ *
+ * \hideinitializer
+ */
+#define PT_FRAME(pt, name) ((PT_LOCALS(name) *)((pt)->frame))
+
+/**
+ * Check at compile time that the frame of a protothread fits the blocks
+ * of its pool.
+ *
+ * \param name The name used with PT_LOCALS().
+ * \param block_size The block size the pool is initialized with.
+ *
+ * \hideinitializer
+ */
+#ifdef __cplusplus
+#define PT_LOCALS_CHECK(name, block_size) \
+  static_assert(sizeof(PT_LOCALS(name)) <= (block_size), "locals frame larger than the pool block")
+#else
+#define PT_LOCALS_CHECK(name, block_size) \
+  _Static_assert(sizeof(PT_LOCALS(name)) <= (block_size), "locals frame larger than the pool block")
+#endif
+
+/**
+ * Initialize a protothread that uses a locals frame.
+ *
+ * Use this instead of PT_INIT(). It also detaches the frame, so a
+ * struct pt with automatic storage never starts with a stale pointer.
+ * PT_INIT() only resets the local continuation, because it is also used
+ * on control structures without a frame.
+ *
+ * \param pt A pointer to the protothread control structure.
+ *
+ * \hideinitializer
+ */
+#define PT_INIT_LOCALS(pt) \
+  do { \
+    PT_INIT(pt); \
+    (pt)->frame = NULL; \
+  } while(0)
+
+/**
+ * Release the locals frame of a protothread instance.
+ *
+ * This is done automatically by PT_END_LOCALS(). Use it manually only
+ * when a protothread is abandoned before it reaches PT_FINALIZED.
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param pool A pointer to the ipc_pool the frame was taken from.
+ *
+ * \hideinitializer
+ */
+#define PT_FREE_LOCALS(pt, pool) \
+  do { \
+    ipc_pool_free((pool), (pt)->frame); \
+    (pt)->frame = NULL; \
+  } while(0)
+
+/**
+ * Declare the start of a protothread with a locals frame.
+ *
+ * Use this instead of PT_BEGIN(). When the protothread starts (its
+ * local continuation is in the initial state and no frame is attached)
+ * a zeroed frame is taken from the pool. If the pool is exhausted the
+ * protothread returns PT_WAITING and tries again the next time it is
+ * scheduled. The pool blocks must fit the frame, see PT_LOCALS_CHECK().
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param name The name used with PT_LOCALS().
+ * \param pool A pointer to the ipc_pool holding the frames.
+ *
+ * \hideinitializer
+ */
+#define PT_BEGIN_LOCALS(pt, name, pool) \
+  if ((pt)->lc == 0 && (pt)->frame == NULL) { \
+    if (((pt)->frame = ipc_pool_alloc(pool)) == NULL) \
+      return PT_WAITING; \
+    memset((pt)->frame, 0, sizeof(PT_LOCALS(name))); \
+  } \
+  PT_BEGIN(pt)
+
+/**
+ * Declare the end of a protothread with a locals frame.
+ *
+ * Use this instead of PT_END(). The frame is given back to the pool
+ * just before the protothread returns PT_FINALIZED, so it is released
+ * after any PT_CATCH(), PT_CATCHANY() or PT_FINALLY() block has run.
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param pool A pointer to the ipc_pool holding the frames.
+ *
+ * \hideinitializer
+ */
+#define PT_END_LOCALS(pt, pool) \
+  LC_END((pt)->lc, PT_FREE_LOCALS(pt, pool); return PT_FINALIZED); \
+  if ((pt)->lc == LC_ERRENC(255)) \
+    PT_FREE_LOCALS(pt, pool); \
+  return (ptstate_t)LC_ERRDEC((pt)->lc, PT_ERROR); \
+  }
+
+#endif /* __PT_LOCALS_H__ */
+
+/** @} */
+/** @} */
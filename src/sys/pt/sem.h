@@ -145,6 +145,9 @@ PT_THREAD(driver_thread(struct pt *pt))
  * the "consumer" and "producer" protothreads declare their local
  * variables as static, to avoid them being stored on the stack.
  *
+ * \note Static locals make the producer and consumer non-reentrant.
+ * Use PT_LOCALS() from pt/locals.h to run several instances of the
+ * same protothread, each with its own locals frame.
  *
  */
 
@@ -0,0 +1,454 @@
+// file: ./src/sys/pt/task.hpp
+
+#ifndef __PT_TASK_HPP__
+#define __PT_TASK_HPP__
+
+/**
+ * @brief C++20 coroutine front-end for protothreads and the process scheduler
+ *
+ * @details
+ * On targets with a C++20 compiler, pd::task<T> lets you write a protothread
+ * as a co_await based coroutine instead of with the PT_* macros. A task is
+ * driven exactly like a protothread: every call to resume() runs it until its
+ * next suspension point and returns a ptstate_t:
+ *
+ * - PT_WAITING   the task is suspended in a co_await
+ * - PT_YIELDED   the task suspended in co_yield (the value is in value())
+ * - PT_EXITED    the task finished with co_return
+ * - 4..254       the task failed with co_await pd::raise(code)
+ * - PT_FINALIZED the task was finalized with finalize() and its frame released
+ *
+ * finalize() destroys the coroutine, which runs the destructors of its locals.
+ * That is the RAII counterpart of a PT_FINALLY() block.
+ *
+ * Coroutine frames are never taken from the heap. They are allocated from the
+ * ipc_pool given to pd::set_frame_pool(); when the pool is exhausted, or its
+ * blocks are too small for the frame or not aligned to std::max_align_t, the
+ * task fails with ERR_HEAP_OOM and valid() is false. The frame size depends
+ * on the compiler and the coroutine body; even an empty loop needs more than
+ * 64 bytes on x86-64.
+ *
+ * A task does not resume just to find out that it must wait again. Awaiters
+ * register a ready predicate with the task, and resume() only resumes the
+ * coroutine once that predicate holds. Available awaiters:
+ *
+ * - pd::wait_one()            suspend until the next resume (PT_WAIT_ONE)
+ * - pd::wait_until(fn, ctx)   suspend until fn(ctx) returns true (PT_WAIT_UNTIL)
+ * - pd::readable(pipe, n)     suspend until the pipe holds n bytes
+ * - pd::writable(pipe, n)     suspend until the pipe has room for n bytes
+ * - pd::sleep(interval)       suspend until a struct timer expires (needs timer.h)
+ * - pd::next_event()          suspend until the next process event
+ * - pd::message()             suspend until the next PROCESS_EVENT_MSG
+ * - pd::spawn(child, fn)      run a classic protothread until it completes (PT_SPAWN)
+ * - pd::join(task)            run another task until it completes
+ * - pd::raise(code)           fail the task with an error code (PT_RAISE)
+ *
+ * The other way round, a classic protothread runs a task with PT_SPAWN_TASK()
+ * or PT_WAIT_TASK(), and PROCESS_TASK() declares a process whose body is a task.
+ *
+ * @code
+ * #include <sys/pt/task.hpp>
+ *
+ * alignas(std::max_align_t) static uint8_t frames_buffer[4][128];
+ * static struct ipc_pool frames;
+ *
+ * PROCESS_TASK(echo_process, "echo", 1)
+ * {
+ *   uint8_t c;
+ *   for (;;) {
+ *     co_await pd::readable(&rx_pipe);
+ *     ipc_pipe_read(&rx_pipe, &c, 1);
+ *     co_await pd::writable(&tx_pipe);
+ *     ipc_pipe_write(&tx_pipe, &c, 1);
+ *   }
+ * }
+ *
+ * void setup() {
+ *   ipc_pool_init(&frames, frames_buffer, sizeof(frames_buffer[0]), 4);
+ *   pd::set_frame_pool(&frames);
+ *   process_init(NULL);
+ *   process_start(&echo_process);
+ * }
+ * @endcode
+ *
+ * @warning
+ * AVR gcc does not support C++20 coroutines. This header is meant for host
+ * tooling and larger targets; it stops compilation with an error otherwise.
+ */
+
+#if !defined(__cplusplus) || !defined(__cpp_impl_coroutine)
+#error "pt/task.hpp requires a C++20 compiler with coroutine support"
+#endif
+
+#include <coroutine>
+#include <cstddef>
+#include <stdint.h>
+
+#include "../pt.h"
+#include "../ipc.h"
+#include "../process.h"
+
+namespace pd {
+
+/* ---------------------------------------------------------------------------
+ * Frame allocation
+ * -------------------------------------------------------------------------*/
+
+/* The pool coroutine frames are allocated from. Set it once, before any task is created. */
+inline struct ipc_pool *frame_pool = nullptr;
+
+inline void set_frame_pool(struct ipc_pool *pool) { frame_pool = pool; }
+
+/* ---------------------------------------------------------------------------
+ * Promise
+ * -------------------------------------------------------------------------*/
+
+typedef bool (*ready_fn)(void *ctx);
+
+/* State shared by the promises of all task<T> types */
+struct promise_base {
+    ptstate_t state = PT_WAITING;     /* last state reported by resume() */
+    ready_fn ready = nullptr;         /* predicate the awaiter waits for (may be NULL) */
+    void *ready_ctx = nullptr;        /* context passed to ready */
+    process_event_t ev = PROCESS_EVENT_NONE;  /* event of the current resume */
+    process_data_t data = nullptr;            /* data of the current resume */
+
+    static void *operator new(size_t size) noexcept
+    {
+        if (!frame_pool || size > frame_pool->block_size) return nullptr;
+        void *blk = ipc_pool_alloc(frame_pool);
+        /* a frame needs the alignment of ::operator new */
+        if (blk && (uintptr_t)blk % alignof(std::max_align_t) != 0) {
+            ipc_pool_free(frame_pool, blk);
+            return nullptr;
+        }
+        return blk;
+    }
+
+    static void operator delete(void *blk) noexcept { ipc_pool_free(frame_pool, blk); }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { state = PT_ERROR; }
+};
+
+template <class T = void> class task;
+
+template <class T>
+struct promise : promise_base {
+    T value{};
+
+    task<T> get_return_object() noexcept;
+    static task<T> get_return_object_on_allocation_failure() noexcept;
+
+    void return_value(T v) noexcept { value = static_cast<T &&>(v); state = PT_EXITED; }
+    std::suspend_always yield_value(T v) noexcept { value = static_cast<T &&>(v); state = PT_YIELDED; return {}; }
+};
+
+template <>
+struct promise<void> : promise_base {
+    task<void> get_return_object() noexcept;
+    static task<void> get_return_object_on_allocation_failure() noexcept;
+
+    void return_void() noexcept { state = PT_EXITED; }
+};
+
+/* ---------------------------------------------------------------------------
+ * Task
+ * -------------------------------------------------------------------------*/
+
+template <class T>
+class task {
+  public:
+    typedef pd::promise<T> promise_type;
+    typedef std::coroutine_handle<promise_type> handle_type;
+
+    task() noexcept : h(nullptr), st(PT_FINALIZED) {}
+    explicit task(handle_type handle) noexcept : h(handle), st(handle ? PT_WAITING : (ptstate_t)ERR_HEAP_OOM) {}
+    task(task &&o) noexcept : h(o.h), st(o.st) { o.h = nullptr; o.st = PT_FINALIZED; }
+    task &operator=(task &&o) noexcept
+    {
+        if (this != &o) {
+            finalize();
+            h = o.h; st = o.st;
+            o.h = nullptr; o.st = PT_FINALIZED;
+        }
+        return *this;
+    }
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+    ~task() { finalize(); }
+
+    /* true while the task holds a coroutine frame */
+    bool valid() const noexcept { return h != nullptr; }
+
+    /* last state reported by resume() or finalize() */
+    ptstate_t state() const noexcept { return h ? h.promise().state : st; }
+
+    /* Run the task until its next suspension point. */
+    ptstate_t resume(process_event_t ev = PROCESS_EVENT_NONE, process_data_t data = nullptr) noexcept
+    {
+        if (!h) return st;
+        promise_type &pr = h.promise();
+        if (!PT_ISRUNNING(pr.state)) return pr.state;   /* completed, waiting for finalize() */
+
+        pr.ev = ev;
+        pr.data = data;
+        if (pr.ready) {
+            if (!pr.ready(pr.ready_ctx)) return PT_WAITING;
+            pr.ready = nullptr;
+        }
+        pr.state = PT_WAITING;
+        h.resume();
+        return pr.state;
+    }
+
+    /* Destroy the coroutine (running the destructors of its locals) and release its frame. */
+    ptstate_t finalize() noexcept
+    {
+        if (h) {
+            h.destroy();
+            h = nullptr;
+        }
+        return st = PT_FINALIZED;
+    }
+
+    /* The value of the last co_yield or co_return (not available for task<void>) */
+    template <class U = T>
+    U &value() noexcept { return h.promise().value; }
+
+  private:
+    handle_type h;
+    ptstate_t st;   /* state reported when there is no frame */
+};
+
+template <class T>
+inline task<T> promise<T>::get_return_object() noexcept
+{ return task<T>(std::coroutine_handle<promise<T>>::from_promise(*this)); }
+
+template <class T>
+inline task<T> promise<T>::get_return_object_on_allocation_failure() noexcept
+{ return task<T>(std::coroutine_handle<promise<T>>(nullptr)); }
+
+inline task<void> promise<void>::get_return_object() noexcept
+{ return task<void>(std::coroutine_handle<promise<void>>::from_promise(*this)); }
+
+inline task<void> promise<void>::get_return_object_on_allocation_failure() noexcept
+{ return task<void>(std::coroutine_handle<promise<void>>(nullptr)); }
+
+/* ---------------------------------------------------------------------------
+ * Awaiters
+ * -------------------------------------------------------------------------*/
+
+/* Base for awaiters that wait for Derived::poll(this) to become true.
+ * The predicate is checked by task::resume() before resuming the coroutine.
+ */
+template <class Derived>
+struct poll_awaiter {
+    static bool poll_ctx(void *self) { return Derived::poll(static_cast<Derived *>(self)); }
+
+    bool await_ready() noexcept { return Derived::poll(static_cast<Derived *>(this)); }
+
+    template <class P>
+    void await_suspend(std::coroutine_handle<P> h) noexcept
+    {
+        h.promise().ready = &poll_ctx;
+        h.promise().ready_ctx = this;
+    }
+};
+
+/* Fail the task with an error code (4..254), like PT_RAISE(). */
+struct raise_awaiter {
+    ptstate_t err;
+    bool await_ready() const noexcept { return false; }
+    template <class P>
+    void await_suspend(std::coroutine_handle<P> h) noexcept
+    {
+        h.promise().state = PT_ISERROR(err) ? err : PT_ERROR;
+    }
+    void await_resume() const noexcept {}
+};
+inline raise_awaiter raise(uint8_t err) noexcept { return raise_awaiter{ (ptstate_t)err }; }
+
+/* Suspend until the next resume, like PT_WAIT_ONE(). */
+inline std::suspend_always wait_one() noexcept { return {}; }
+
+/* Suspend until fn(ctx) returns true, like PT_WAIT_UNTIL(). */
+struct until_awaiter : poll_awaiter<until_awaiter> {
+    ready_fn fn;
+    void *ctx;
+    static bool poll(until_awaiter *a) { return a->fn(a->ctx); }
+    void await_resume() const noexcept {}
+};
+inline until_awaiter wait_until(ready_fn fn, void *ctx) noexcept
+{ until_awaiter a; a.fn = fn; a.ctx = ctx; return a; }
+
+/* Suspend until the pipe holds at least n bytes. */
+struct readable_awaiter : poll_awaiter<readable_awaiter> {
+    const ipc_pipe_t *pipe;
+    size_t n;
+    static bool poll(readable_awaiter *a) { return ipc_pipe_available(a->pipe) >= a->n; }
+    size_t await_resume() const noexcept { return ipc_pipe_available(pipe); }
+};
+inline readable_awaiter readable(const ipc_pipe_t *p, size_t n = 1) noexcept
+{ readable_awaiter a; a.pipe = p; a.n = n; return a; }
+
+/* Suspend until the pipe has room for at least n bytes. */
+struct writable_awaiter : poll_awaiter<writable_awaiter> {
+    const ipc_pipe_t *pipe;
+    size_t n;
+    static bool poll(writable_awaiter *a) { return ipc_pipe_space(a->pipe) >= a->n; }
+    size_t await_resume() const noexcept { return ipc_pipe_space(pipe); }
+};
+inline writable_awaiter writable(const ipc_pipe_t *p, size_t n = 1) noexcept
+{ writable_awaiter a; a.pipe = p; a.n = n; return a; }
+
+#ifdef __TIMER_H__
+/* Suspend until the interval has passed, like PT_WAIT_DELAY() but per instance. */
+struct sleep_awaiter : poll_awaiter<sleep_awaiter> {
+    struct timer t;
+    static bool poll(sleep_awaiter *a) { return timer_expired(&a->t) != 0; }
+    void await_resume() const noexcept {}
+};
+inline sleep_awaiter sleep(clock_time_t interval) noexcept
+{ sleep_awaiter a; timer_set(&a.t, interval); return a; }
+#endif
+
+/* A process event as seen by a task */
+struct event {
+    process_event_t ev;
+    process_data_t data;
+};
+
+/* Suspend until the task is resumed with a process event of type ev
+ * (any event when ev is PROCESS_EVENT_NONE). Always waits for a new event.
+ */
+struct event_awaiter : poll_awaiter<event_awaiter> {
+    process_event_t ev;
+    promise_base *pr = nullptr;
+    static bool poll(event_awaiter *a)
+    {
+        return a->pr && a->pr->ev != PROCESS_EVENT_NONE
+            && (a->ev == PROCESS_EVENT_NONE || a->pr->ev == a->ev);
+    }
+    template <class P>
+    void await_suspend(std::coroutine_handle<P> h) noexcept
+    {
+        pr = &h.promise();
+        poll_awaiter<event_awaiter>::await_suspend(h);
+    }
+    event await_resume() const noexcept { return event{ pr->ev, pr->data }; }
+};
+inline event_awaiter next_event(process_event_t ev = PROCESS_EVENT_NONE) noexcept
+{ event_awaiter a; a.ev = ev; return a; }
+
+/* Suspend until the next PROCESS_EVENT_MSG and return its message. */
+struct message_awaiter : event_awaiter {
+    ipc_msg_t *await_resume() const noexcept { return (ipc_msg_t *)pr->data; }
+};
+inline message_awaiter message() noexcept
+{ message_awaiter a; a.ev = PROCESS_EVENT_MSG; return a; }
+
+/* Run a classic protothread until it completes, like PT_SPAWN().
+ * fn is called without arguments and must return the child's ptstate_t,
+ * for example [&] { return worker(&child, 42); }. Returns the final state.
+ */
+template <class F>
+struct spawn_awaiter : poll_awaiter<spawn_awaiter<F>> {
+    struct pt *child;
+    F fn;
+    ptstate_t result;
+    spawn_awaiter(struct pt *c, F f) : child(c), fn(f), result(PT_WAITING) { PT_INIT(c); }
+    static bool poll(spawn_awaiter *a) { return !PT_ISRUNNING(a->result = a->fn()); }
+    ptstate_t await_resume() const noexcept { return result; }
+};
+template <class F>
+inline spawn_awaiter<F> spawn(struct pt *child, F fn) { return spawn_awaiter<F>(child, fn); }
+
+/* Run another task until it completes. Returns its final state; the value of
+ * a task<T> remains available through value() until the child is finalized.
+ */
+template <class T>
+struct join_awaiter : poll_awaiter<join_awaiter<T>> {
+    task<T> *child;
+    ptstate_t result;
+    static bool poll(join_awaiter *a) { return !PT_ISRUNNING(a->result = a->child->resume()); }
+    ptstate_t await_resume() const noexcept { return result; }
+};
+template <class T>
+inline join_awaiter<T> join(task<T> &child) { join_awaiter<T> a; a.child = &child; a.result = PT_WAITING; return a; }
+
+/* ---------------------------------------------------------------------------
+ * Process scheduler integration
+ * -------------------------------------------------------------------------*/
+
+/* Drive a task from a process thread. The task is created with factory() when
+ * the process starts, resumed for every event, and finalized when the scheduler
+ * arms finalization with PT_FINAL().
+ */
+template <class T>
+inline ptstate_t process_drive(task<T> &t, struct pt *pt, process_event_t ev, process_data_t data, task<T> (*factory)(void))
+{
+    lc_t final;
+    LC_FINAL(final);
+    if (pt->lc == final)
+        return t.finalize();
+    if (pt->lc == 0 && !t.valid())
+        t = factory();
+    return t.resume(ev, data);
+}
+
+} /* namespace pd */
+
+/**
+ * Declare a process whose body is a pd::task<void> coroutine.
+ *
+ * The body follows the macro. Use co_await pd::next_event() to receive the
+ * events posted to the process; the event that started the task
+ * (PROCESS_EVENT_INIT) is already consumed when the body starts.
+ *
+ * \hideinitializer
+ */
+#define PROCESS_TASK(name, strname, priority) \
+  static pd::task<void> process_task_##name(void); \
+  PROCESS(name, strname, priority); \
+  PROCESS_THREAD(name, ev, data) \
+  { \
+    static pd::task<void> task; \
+    return pd::process_drive(task, pt_process, ev, data, process_task_##name); \
+  } \
+  static pd::task<void> process_task_##name(void)
+
+/**
+ * Block a protothread until a task completes, then finalize the task.
+ * An error of the task is raised in the protothread.
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param task A pd::task that must outlive the wait (e.g. static).
+ *
+ * \hideinitializer
+ */
+#define PT_WAIT_TASK(pt, task) \
+  do { \
+    PT_WAIT_WHILE(pt, PT_SCHEDULE((task).resume())); \
+    (task).finalize(); \
+    PT_ONERROR(PT_ERROR_STATE) \
+      PT_RAISE(pt, PT_ERROR_STATE); \
+  } while(0)
+
+/**
+ * Create a task and block a protothread until it completes, like PT_SPAWN().
+ *
+ * \param pt A pointer to the protothread control structure.
+ * \param task A pd::task that must outlive the wait (e.g. static).
+ * \param call The coroutine call that creates the task.
+ *
+ * \hideinitializer
+ */
+#define PT_SPAWN_TASK(pt, task, call) \
+  do { \
+    (task) = (call); \
+    PT_WAIT_TASK(pt, task); \
+  } while(0)
+
+#endif /* __PT_TASK_HPP__ */
@@ -1,31 +1,94 @@
+// file: ./src/sys/pt/types.h
 
+/**
+ * \addtogroup pt
+ * @{
+ */
 
-#include "lc.h"
-#include "../../utf/rune16.h"
+/**
+ * \file
+ * Typed control structures for iterator protothreads.
+ *
+ * An iterator protothread stores the value it yields in its own
+ * control structure, next to the local continuation. The caller reads
+ * the value in the body of PT_FOREACH(). The structures in this file
+ * cover the common cases; any structure with an lc_t lc member can be
+ * used in the same way.
+ *
+ \code
+static ptstate_t counter(struct value_pt *self, uint8_t max)
+{
+  PT_BEGIN(self);
+
+  for (self->value = 0; self->value < max; )
+    PT_YIELD_VALUE(self, self->value + 1);
+
+  PT_END(self);
+}
+ \endcode
+ *
+ * For generators that are chained into a pipeline, see gen.h.
+ *
+ * \author
+ * Joham https://github.com/jklarenbeek
+ */
 
+#ifndef __PT_TYPES_H__
+#define __PT_TYPES_H__
+
+#include <stdint.h>
+
+#include "../pt.h"
+#include "../../lib/utf/rune16.h"
+
+/** Control structure of a protothread that yields bytes */
 struct value_pt
 {
-    lc_t lc;
-    uint8_t value; // T value
-}
+  lc_t lc;
+  uint8_t value;        // yielded value
+};
 
+/** Control structure of a protothread that yields runes */
 struct rune16_pt
 {
-    lc_t lc;
-    rune16_t value;
-}
+  lc_t lc;
+  rune16_t value;       // yielded rune
+};
 
+/** Control structure of a protothread that fills and yields a buffer */
 struct buf8_pt
 {
-    lc_t lc;
-    uint8_t idx;       // current index of buffer
-    uint8_t buf[idx];  // current escape buffer
-}
+  lc_t lc;
+  uint8_t idx;                    // current index of buffer
+  uint8_t buf[PT_CONF_BUF8_SIZE]; // current buffer
+};
+
+#ifdef __cplusplus
+class Stream;
 
+/** Control structure of a protothread that reads runes from a stream */
 struct stream8_pt
 {
   lc_t lc;
-  Stream * stream;              // stream for getc and putc
-}
+  Stream *stream;       // stream for getc and putc
+  rune16_t value;       // yielded rune
+};
+#endif
+
+/**
+ * Store a value in the control structure and yield it.
+ *
+ * \param pt A pointer to a control structure with a value member.
+ * \param v The value to yield.
+ *
+ * \hideinitializer
+ */
+#define PT_YIELD_VALUE(pt, v) \
+  do { \
+    (pt)->value = (v); \
+    PT_YIELD(pt); \
+  } while(0)
 
+#endif /* __PT_TYPES_H__ */
 
+/** @} */
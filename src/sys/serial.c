@@ -69,3 +69,21 @@ void print_dec(uint8_t val)
         printchar(numbuf[i]);
     }
 }
+
+// ---------------------------------------------------------------------------
+// Helper: Print 32-bit Unsigned Integer
+// ---------------------------------------------------------------------------
+void print_dec32(uint32_t val)
+{
+    char numbuf[10];
+    uint8_t i = 0;
+    do
+    {
+        numbuf[i++] = '0' + (val % 10);
+        val /= 10;
+    } while (val > 0);
+    while (i--)
+    {
+        printchar(numbuf[i]);
+    }
+}
@@ -23,6 +23,13 @@
 
 CC_EXTERN typedef bool (*serial_onrecieved_fn)(uint_fast8_t);
 
+/* Called from the TX interrupt each time a byte left the TX ring buffer.
+ * The signature matches ipc_wake_cb_t, e.g. process_cond_signal(). */
+CC_EXTERN typedef void (*serial_ontransmitted_fn)(void *ctx);
+
+/* Source of serial[0..3]_splice(), see ipc.h */
+struct ipc_pipe;
+
 #ifdef HAVE_HW_UART0
 #undef CC_TMPL_PREFIX
 #define CC_TMPL_PREFIX serial0
@@ -55,5 +62,6 @@ CC_EXTERN void println_P(const char *s);
 
 CC_EXTERN void print(const char *s);
 CC_EXTERN void print_dec(uint8_t val);
+CC_EXTERN void print_dec32(uint32_t val);
 
 #endif /* __SERIAL_H__ */
\ No newline at end of file
@@ -82,6 +82,20 @@ CC_EXTERN uint_fast32_t CC_TMPL_FN(get_read_overflow)(void);
  */
 CC_EXTERN void CC_TMPL_FN(on_recieved)(const serial_onrecieved_fn callback);
 
+/**
+ * @fn void serial[0..3]_on_transmitted(serial_ontransmitted_fn callback, void *ctx)
+ * @brief Sets the callback function that is invoked when space in the TX buffer is freed.
+ *
+ * The callback runs in interrupt context each time the TX interrupt took a byte from the
+ * ring buffer, so it must be short and ISR-safe. A typical callback is process_cond_signal(),
+ * which wakes the processes waiting with PT_WAIT_COND() until serial[0..3]_write_available()
+ * is large enough. Set to NULL to disable.
+ *
+ * @param callback The callback function pointer, or NULL to disable.
+ * @param ctx The context passed to the callback.
+ */
+CC_EXTERN void CC_TMPL_FN(on_transmitted)(const serial_ontransmitted_fn callback, void *ctx);
+
 /**
  * @fn void serial[0..3]_open(uint32_t baud)
  * @brief Initializes and opens the serial port with default configuration.
@@ -236,6 +250,20 @@ CC_EXTERN uint_fast8_t CC_TMPL_FN(write24)(const uint_fast32_t data);
  */
 CC_EXTERN uint_fast8_t CC_TMPL_FN(write32)(const uint_fast32_t data);
 
+/**
+ * @fn uint_fast8_t serial[0..3]_splice(struct ipc_pipe *src, uint_fast8_t max)
+ * @brief Moves bytes from an IPC pipe straight into the transmit buffer.
+ *
+ * Copies up to max bytes from src into the TX ring buffer with ipc_pipe_splice_ringb8(), one
+ * contiguous chunk per atomic section and without an intermediate buffer, and enables the TX
+ * interrupt. The bytes leave src, so src's space callback can wake its writer.
+ *
+ * @param src The pipe to read from.
+ * @param max The maximum number of bytes to move.
+ * @return The number of bytes moved (0 if src is empty or the buffer is full).
+ */
+CC_EXTERN uint_fast8_t CC_TMPL_FN(splice)(struct ipc_pipe *src, uint_fast8_t max);
+
 /**
  * @fn uint_fast8_t serial[0..3]_flush(void)
  * @brief Flushes the transmit buffer by sending remaining data.
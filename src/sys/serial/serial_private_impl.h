@@ -6,6 +6,8 @@
 
 #include "../../lib/ringb8.h"
 
+#include "../ipc.h"
+
 #include <util/atomic.h> // <-- important!!
 
 RINGB8(CC_TMPL_VAR(rx), SERIAL_RX_BUFFER_SIZE);
@@ -15,6 +17,8 @@ RINGB8(CC_TMPL_VAR(tx), SERIAL_TX_BUFFER_SIZE);
 #define VAR_TX VAR_RINGB8(CC_TMPL_VAR(tx))
 
 static volatile serial_onrecieved_fn CC_TMPL_VAR(onrecieved_callback) = 0;
+static volatile serial_ontransmitted_fn CC_TMPL_VAR(ontransmitted_callback) = 0;
+static void * volatile CC_TMPL_VAR(ontransmitted_ctx) = 0;
 
 #ifdef SERIAL_REGISTER_ERRORS
 static uint32_t CC_TMPL_VAR(rx_errcnt) = 0;
@@ -63,9 +67,16 @@ static void CC_TMPL_FN(on_rx_error)(uint_fast8_t err)
 static int_fast16_t CC_TMPL_FN(on_tx_complete)(void)
 {
   // is there anything to transmit?
-  return ringb8_count(&VAR_TX) > 0
-    ? ringb8_get(&VAR_TX)
-    : -1;
+  if (ringb8_count(&VAR_TX) == 0)
+    return -1;
+
+  int_fast16_t data = ringb8_get(&VAR_TX);
+
+  // tell the subscriber that there is room in the buffer
+  if (CC_TMPL_VAR(ontransmitted_callback) != 0)
+    CC_TMPL_VAR(ontransmitted_callback)(CC_TMPL_VAR(ontransmitted_ctx));
+
+  return data;
 }
 
 void CC_TMPL_FN(on_recieved)(const serial_onrecieved_fn callback)
@@ -73,6 +84,15 @@ void CC_TMPL_FN(on_recieved)(const serial_onrecieved_fn callback)
   CC_TMPL_VAR(onrecieved_callback) = callback;
 }
 
+void CC_TMPL_FN(on_transmitted)(const serial_ontransmitted_fn callback, void *ctx)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    CC_TMPL_VAR(ontransmitted_callback) = callback;
+    CC_TMPL_VAR(ontransmitted_ctx) = ctx;
+  }
+}
+
 void CC_TMPL_FN(open)(uint32_t baud)
 {
   CC_TMPL2_FN(on_rx_complete)(CC_TMPL_FN(on_rx_complete));
@@ -281,6 +301,19 @@ CC_FLATTEN uint_fast8_t CC_TMPL_FN(write32)(const uint_fast32_t data)
   return 4;
 }
 
+uint_fast8_t CC_TMPL_FN(splice)(struct ipc_pipe *src, uint_fast8_t max)
+{
+  uint_fast8_t n = (uint_fast8_t)ipc_pipe_splice_ringb8(&VAR_TX, src, max);
+  if (n > 0)
+  {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      CC_TMPL2_FN(tx_enable_int)();
+    }
+  }
+  return n;
+}
+
 uint_fast8_t CC_TMPL_FN(flush)(void)
 {
   // get the amount of bytes still to be transmitted
@@ -48,7 +48,7 @@ static CC_ALWAYS_INLINE void timer_set(struct timer *t, const clock_time_t inter
 static CC_ALWAYS_INLINE clock_time_t timer_diff(const struct timer *t) {
   register clock_time_t d = clock_time();
   register clock_time_t s = t->start;
-  if (d > s) {
+  if (d >= s) {
     return d - s;
   }
   else {